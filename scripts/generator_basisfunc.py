@@ -1,3 +1,4 @@
+import sys
 import sympy as sy
 
 def lagrange1d(i, p, x):
@@ -9,13 +10,110 @@ def lagrange1d(i, p, x):
       eval *= (x - xj) / (xi - xj)
   return eval
 
-x = sy.Symbol("x")
+# symbolic forms (used for the hand written p <= 3 kernels in basis.glsl)
 
-for p in range(1,4):
-  print(f"p: {p}")
-  for bfunc in range(p + 1):
-    print(f"  func: {bfunc}")
-    eval = lagrange1d(bfunc, p, x)
-    print("   ", sy.simplify(eval))
-    print("   ", sy.simplify(sy.diff(eval, x)))
-  print("")
+def print_symbolic(pmin, pmax):
+  x = sy.Symbol("x")
+
+  for p in range(pmin, pmax + 1):
+    print(f"p: {p}")
+    for bfunc in range(p + 1):
+      print(f"  func: {bfunc}")
+      eval = lagrange1d(bfunc, p, x)
+      print("   ", sy.simplify(eval))
+      print("   ", sy.simplify(sy.diff(eval, x)))
+    print("")
+
+# unrolled GLSL kernels for higher orders
+#
+# Expanded monomial forms lose precision quickly past p = 3, so these use the
+# product form phi_i = w_i * prod_{j != i} (x - x_j) with prefix / suffix
+# products over the node distances. The derivative chains the same prefix /
+# suffix products, keeping both kernels O(p) and free of divisions.
+
+def fmt(val):
+  return f"{float(val):.9e}"
+
+def node(j, p):
+  return sy.Rational(j, p)
+
+def weight(i, p):
+  w = sy.Integer(1)
+  for j in range(p + 1):
+    if j != i:
+      w *= node(i, p) - node(j, p)
+  return 1 / w
+
+def glsl_distances(p):
+  lines = []
+  for j in range(p + 1):
+    if j == 0:
+      lines.append(f"  float d0 = x;")
+    else:
+      lines.append(f"  float d{j} = x - {fmt(node(j, p))};")
+  return lines
+
+def glsl_products(p):
+  lines = ["  float l1 = d0;"]
+  for k in range(2, p + 1):
+    lines.append(f"  float l{k} = l{k - 1} * d{k - 1};")
+  lines.append(f"  float r{p - 1} = d{p};")
+  for k in range(p - 2, -1, -1):
+    lines.append(f"  float r{k} = d{k + 1} * r{k + 1};")
+  return lines
+
+def glsl_dproducts(p):
+  lines = ["  float dl1 = 1.;"]
+  for k in range(2, p + 1):
+    lines.append(f"  float dl{k} = dl{k - 1} * d{k - 1} + l{k - 1};")
+  lines.append(f"  float dr{p - 1} = 1.;")
+  for k in range(p - 2, -1, -1):
+    lines.append(f"  float dr{k} = d{k + 1} * dr{k + 1} + r{k + 1};")
+  return lines
+
+def glsl_kernel(p):
+  out = []
+
+  out.append(f"void lagrange_lin{p}(const in float x, out float phi[mop1])")
+  out.append("{")
+  out += glsl_distances(p)
+  out += glsl_products(p)
+  for i in range(p + 1):
+    w = fmt(weight(i, p))
+    if i == 0:
+      out.append(f"  phi[{i}] = {w} * r0;")
+    elif i == p:
+      out.append(f"  phi[{i}] = {w} * l{p};")
+    else:
+      out.append(f"  phi[{i}] = {w} * l{i} * r{i};")
+  out.append("}")
+
+  out.append(f"void dlagrange_lin{p}(const in float x, out float dphi[mop1])")
+  out.append("{")
+  out += glsl_distances(p)
+  out += glsl_products(p)
+  out += glsl_dproducts(p)
+  for i in range(p + 1):
+    w = fmt(weight(i, p))
+    if i == 0:
+      out.append(f"  dphi[{i}] = {w} * dr0;")
+    elif i == p:
+      out.append(f"  dphi[{i}] = {w} * dl{p};")
+    else:
+      out.append(f"  dphi[{i}] = {w} * (dl{i} * r{i} + l{i} * dr{i});")
+  out.append("}")
+
+  return "\n".join(out)
+
+# usage: generator_basisfunc.py [symbolic | glsl] [pmin] [pmax]
+
+mode = sys.argv[1] if len(sys.argv) > 1 else "glsl"
+pmin = int(sys.argv[2]) if len(sys.argv) > 2 else 4
+pmax = int(sys.argv[3]) if len(sys.argv) > 3 else 8
+
+if mode == "symbolic":
+  print_symbolic(pmin, pmax)
+else:
+  for p in range(pmin, pmax + 1):
+    print(glsl_kernel(p))
+    print("")
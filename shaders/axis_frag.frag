@@ -20,6 +20,8 @@ layout(location = 0) in vec3 frag_color;
 
 layout(location = 0) out vec4 out_color;
 
+// zero alpha marks ui pixels for the edge aware upsampling (see upsample.glsl),
+// the swap chain is opaque so it is otherwise ignored
 void main() {
-  out_color = vec4(frag_color, 1.);
+  out_color = vec4(frag_color, 0.);
 }
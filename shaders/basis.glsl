@@ -53,7 +53,7 @@ float lagrange3d(const in uint bi, const in uint p, const in vec3 pos)
 
 /* hard coded Lagrange functions */
 
-const uint max_order = 3;
+const uint max_order = 8;
 const uint mop1      = max_order + 1;
 
 void lagrange_lin0(const in float x, out float phi[mop1])
@@ -104,6 +104,363 @@ void dlagrange_lin3(const in float x, out float dphi[mop1])
   dphi[3] = +13.5 * x * x -  9. * x + 1. ;
 }
 
+// generated by scripts/generator_basisfunc.py (product form, see script)
+
+void lagrange_lin4(const in float x, out float phi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 2.500000000e-01;
+  float d2 = x - 5.000000000e-01;
+  float d3 = x - 7.500000000e-01;
+  float d4 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float r3 = d4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  phi[0] = 1.066666667e+01 * r0;
+  phi[1] = -4.266666667e+01 * l1 * r1;
+  phi[2] = 6.400000000e+01 * l2 * r2;
+  phi[3] = -4.266666667e+01 * l3 * r3;
+  phi[4] = 1.066666667e+01 * l4;
+}
+void dlagrange_lin4(const in float x, out float dphi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 2.500000000e-01;
+  float d2 = x - 5.000000000e-01;
+  float d3 = x - 7.500000000e-01;
+  float d4 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float r3 = d4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  float dl1 = 1.;
+  float dl2 = dl1 * d1 + l1;
+  float dl3 = dl2 * d2 + l2;
+  float dl4 = dl3 * d3 + l3;
+  float dr3 = 1.;
+  float dr2 = d3 * dr3 + r3;
+  float dr1 = d2 * dr2 + r2;
+  float dr0 = d1 * dr1 + r1;
+  dphi[0] = 1.066666667e+01 * dr0;
+  dphi[1] = -4.266666667e+01 * (dl1 * r1 + l1 * dr1);
+  dphi[2] = 6.400000000e+01 * (dl2 * r2 + l2 * dr2);
+  dphi[3] = -4.266666667e+01 * (dl3 * r3 + l3 * dr3);
+  dphi[4] = 1.066666667e+01 * dl4;
+}
+
+void lagrange_lin5(const in float x, out float phi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 2.000000000e-01;
+  float d2 = x - 4.000000000e-01;
+  float d3 = x - 6.000000000e-01;
+  float d4 = x - 8.000000000e-01;
+  float d5 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float r4 = d5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  phi[0] = -2.604166667e+01 * r0;
+  phi[1] = 1.302083333e+02 * l1 * r1;
+  phi[2] = -2.604166667e+02 * l2 * r2;
+  phi[3] = 2.604166667e+02 * l3 * r3;
+  phi[4] = -1.302083333e+02 * l4 * r4;
+  phi[5] = 2.604166667e+01 * l5;
+}
+void dlagrange_lin5(const in float x, out float dphi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 2.000000000e-01;
+  float d2 = x - 4.000000000e-01;
+  float d3 = x - 6.000000000e-01;
+  float d4 = x - 8.000000000e-01;
+  float d5 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float r4 = d5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  float dl1 = 1.;
+  float dl2 = dl1 * d1 + l1;
+  float dl3 = dl2 * d2 + l2;
+  float dl4 = dl3 * d3 + l3;
+  float dl5 = dl4 * d4 + l4;
+  float dr4 = 1.;
+  float dr3 = d4 * dr4 + r4;
+  float dr2 = d3 * dr3 + r3;
+  float dr1 = d2 * dr2 + r2;
+  float dr0 = d1 * dr1 + r1;
+  dphi[0] = -2.604166667e+01 * dr0;
+  dphi[1] = 1.302083333e+02 * (dl1 * r1 + l1 * dr1);
+  dphi[2] = -2.604166667e+02 * (dl2 * r2 + l2 * dr2);
+  dphi[3] = 2.604166667e+02 * (dl3 * r3 + l3 * dr3);
+  dphi[4] = -1.302083333e+02 * (dl4 * r4 + l4 * dr4);
+  dphi[5] = 2.604166667e+01 * dl5;
+}
+
+void lagrange_lin6(const in float x, out float phi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 1.666666667e-01;
+  float d2 = x - 3.333333333e-01;
+  float d3 = x - 5.000000000e-01;
+  float d4 = x - 6.666666667e-01;
+  float d5 = x - 8.333333333e-01;
+  float d6 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float l6 = l5 * d5;
+  float r5 = d6;
+  float r4 = d5 * r5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  phi[0] = 6.480000000e+01 * r0;
+  phi[1] = -3.888000000e+02 * l1 * r1;
+  phi[2] = 9.720000000e+02 * l2 * r2;
+  phi[3] = -1.296000000e+03 * l3 * r3;
+  phi[4] = 9.720000000e+02 * l4 * r4;
+  phi[5] = -3.888000000e+02 * l5 * r5;
+  phi[6] = 6.480000000e+01 * l6;
+}
+void dlagrange_lin6(const in float x, out float dphi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 1.666666667e-01;
+  float d2 = x - 3.333333333e-01;
+  float d3 = x - 5.000000000e-01;
+  float d4 = x - 6.666666667e-01;
+  float d5 = x - 8.333333333e-01;
+  float d6 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float l6 = l5 * d5;
+  float r5 = d6;
+  float r4 = d5 * r5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  float dl1 = 1.;
+  float dl2 = dl1 * d1 + l1;
+  float dl3 = dl2 * d2 + l2;
+  float dl4 = dl3 * d3 + l3;
+  float dl5 = dl4 * d4 + l4;
+  float dl6 = dl5 * d5 + l5;
+  float dr5 = 1.;
+  float dr4 = d5 * dr5 + r5;
+  float dr3 = d4 * dr4 + r4;
+  float dr2 = d3 * dr3 + r3;
+  float dr1 = d2 * dr2 + r2;
+  float dr0 = d1 * dr1 + r1;
+  dphi[0] = 6.480000000e+01 * dr0;
+  dphi[1] = -3.888000000e+02 * (dl1 * r1 + l1 * dr1);
+  dphi[2] = 9.720000000e+02 * (dl2 * r2 + l2 * dr2);
+  dphi[3] = -1.296000000e+03 * (dl3 * r3 + l3 * dr3);
+  dphi[4] = 9.720000000e+02 * (dl4 * r4 + l4 * dr4);
+  dphi[5] = -3.888000000e+02 * (dl5 * r5 + l5 * dr5);
+  dphi[6] = 6.480000000e+01 * dl6;
+}
+
+void lagrange_lin7(const in float x, out float phi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 1.428571429e-01;
+  float d2 = x - 2.857142857e-01;
+  float d3 = x - 4.285714286e-01;
+  float d4 = x - 5.714285714e-01;
+  float d5 = x - 7.142857143e-01;
+  float d6 = x - 8.571428571e-01;
+  float d7 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float l6 = l5 * d5;
+  float l7 = l6 * d6;
+  float r6 = d7;
+  float r5 = d6 * r6;
+  float r4 = d5 * r5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  phi[0] = -1.634013889e+02 * r0;
+  phi[1] = 1.143809722e+03 * l1 * r1;
+  phi[2] = -3.431429167e+03 * l2 * r2;
+  phi[3] = 5.719048611e+03 * l3 * r3;
+  phi[4] = -5.719048611e+03 * l4 * r4;
+  phi[5] = 3.431429167e+03 * l5 * r5;
+  phi[6] = -1.143809722e+03 * l6 * r6;
+  phi[7] = 1.634013889e+02 * l7;
+}
+void dlagrange_lin7(const in float x, out float dphi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 1.428571429e-01;
+  float d2 = x - 2.857142857e-01;
+  float d3 = x - 4.285714286e-01;
+  float d4 = x - 5.714285714e-01;
+  float d5 = x - 7.142857143e-01;
+  float d6 = x - 8.571428571e-01;
+  float d7 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float l6 = l5 * d5;
+  float l7 = l6 * d6;
+  float r6 = d7;
+  float r5 = d6 * r6;
+  float r4 = d5 * r5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  float dl1 = 1.;
+  float dl2 = dl1 * d1 + l1;
+  float dl3 = dl2 * d2 + l2;
+  float dl4 = dl3 * d3 + l3;
+  float dl5 = dl4 * d4 + l4;
+  float dl6 = dl5 * d5 + l5;
+  float dl7 = dl6 * d6 + l6;
+  float dr6 = 1.;
+  float dr5 = d6 * dr6 + r6;
+  float dr4 = d5 * dr5 + r5;
+  float dr3 = d4 * dr4 + r4;
+  float dr2 = d3 * dr3 + r3;
+  float dr1 = d2 * dr2 + r2;
+  float dr0 = d1 * dr1 + r1;
+  dphi[0] = -1.634013889e+02 * dr0;
+  dphi[1] = 1.143809722e+03 * (dl1 * r1 + l1 * dr1);
+  dphi[2] = -3.431429167e+03 * (dl2 * r2 + l2 * dr2);
+  dphi[3] = 5.719048611e+03 * (dl3 * r3 + l3 * dr3);
+  dphi[4] = -5.719048611e+03 * (dl4 * r4 + l4 * dr4);
+  dphi[5] = 3.431429167e+03 * (dl5 * r5 + l5 * dr5);
+  dphi[6] = -1.143809722e+03 * (dl6 * r6 + l6 * dr6);
+  dphi[7] = 1.634013889e+02 * dl7;
+}
+
+void lagrange_lin8(const in float x, out float phi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 1.250000000e-01;
+  float d2 = x - 2.500000000e-01;
+  float d3 = x - 3.750000000e-01;
+  float d4 = x - 5.000000000e-01;
+  float d5 = x - 6.250000000e-01;
+  float d6 = x - 7.500000000e-01;
+  float d7 = x - 8.750000000e-01;
+  float d8 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float l6 = l5 * d5;
+  float l7 = l6 * d6;
+  float l8 = l7 * d7;
+  float r7 = d8;
+  float r6 = d7 * r7;
+  float r5 = d6 * r6;
+  float r4 = d5 * r5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  phi[0] = 4.161015873e+02 * r0;
+  phi[1] = -3.328812698e+03 * l1 * r1;
+  phi[2] = 1.165084444e+04 * l2 * r2;
+  phi[3] = -2.330168889e+04 * l3 * r3;
+  phi[4] = 2.912711111e+04 * l4 * r4;
+  phi[5] = -2.330168889e+04 * l5 * r5;
+  phi[6] = 1.165084444e+04 * l6 * r6;
+  phi[7] = -3.328812698e+03 * l7 * r7;
+  phi[8] = 4.161015873e+02 * l8;
+}
+void dlagrange_lin8(const in float x, out float dphi[mop1])
+{
+  float d0 = x;
+  float d1 = x - 1.250000000e-01;
+  float d2 = x - 2.500000000e-01;
+  float d3 = x - 3.750000000e-01;
+  float d4 = x - 5.000000000e-01;
+  float d5 = x - 6.250000000e-01;
+  float d6 = x - 7.500000000e-01;
+  float d7 = x - 8.750000000e-01;
+  float d8 = x - 1.000000000e+00;
+  float l1 = d0;
+  float l2 = l1 * d1;
+  float l3 = l2 * d2;
+  float l4 = l3 * d3;
+  float l5 = l4 * d4;
+  float l6 = l5 * d5;
+  float l7 = l6 * d6;
+  float l8 = l7 * d7;
+  float r7 = d8;
+  float r6 = d7 * r7;
+  float r5 = d6 * r6;
+  float r4 = d5 * r5;
+  float r3 = d4 * r4;
+  float r2 = d3 * r3;
+  float r1 = d2 * r2;
+  float r0 = d1 * r1;
+  float dl1 = 1.;
+  float dl2 = dl1 * d1 + l1;
+  float dl3 = dl2 * d2 + l2;
+  float dl4 = dl3 * d3 + l3;
+  float dl5 = dl4 * d4 + l4;
+  float dl6 = dl5 * d5 + l5;
+  float dl7 = dl6 * d6 + l6;
+  float dl8 = dl7 * d7 + l7;
+  float dr7 = 1.;
+  float dr6 = d7 * dr7 + r7;
+  float dr5 = d6 * dr6 + r6;
+  float dr4 = d5 * dr5 + r5;
+  float dr3 = d4 * dr4 + r4;
+  float dr2 = d3 * dr3 + r3;
+  float dr1 = d2 * dr2 + r2;
+  float dr0 = d1 * dr1 + r1;
+  dphi[0] = 4.161015873e+02 * dr0;
+  dphi[1] = -3.328812698e+03 * (dl1 * r1 + l1 * dr1);
+  dphi[2] = 1.165084444e+04 * (dl2 * r2 + l2 * dr2);
+  dphi[3] = -2.330168889e+04 * (dl3 * r3 + l3 * dr3);
+  dphi[4] = 2.912711111e+04 * (dl4 * r4 + l4 * dr4);
+  dphi[5] = -2.330168889e+04 * (dl5 * r5 + l5 * dr5);
+  dphi[6] = 1.165084444e+04 * (dl6 * r6 + l6 * dr6);
+  dphi[7] = -3.328812698e+03 * (dl7 * r7 + l7 * dr7);
+  dphi[8] = 4.161015873e+02 * dl8;
+}
+
 void lagrange_lin(const in uint p, const in float x, out float phi[mop1])
 {
   switch (p)
@@ -120,6 +477,21 @@ void lagrange_lin(const in uint p, const in float x, out float phi[mop1])
     case 3:
       lagrange_lin3(x, phi);
       break;
+    case 4:
+      lagrange_lin4(x, phi);
+      break;
+    case 5:
+      lagrange_lin5(x, phi);
+      break;
+    case 6:
+      lagrange_lin6(x, phi);
+      break;
+    case 7:
+      lagrange_lin7(x, phi);
+      break;
+    case 8:
+      lagrange_lin8(x, phi);
+      break;
   }
 }
 
@@ -139,6 +511,21 @@ void dlagrange_lin(const in uint p, const in float x, out float dphi[mop1])
     case 3:
       dlagrange_lin3(x, dphi);
       break;
+    case 4:
+      dlagrange_lin4(x, dphi);
+      break;
+    case 5:
+      dlagrange_lin5(x, dphi);
+      break;
+    case 6:
+      dlagrange_lin6(x, dphi);
+      break;
+    case 7:
+      dlagrange_lin7(x, dphi);
+      break;
+    case 8:
+      dlagrange_lin8(x, dphi);
+      break;
   }
 }
 
@@ -0,0 +1,201 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_BERNSTEIN
+#define SHDR_BERNSTEIN
+
+
+#include "basis.glsl"
+
+
+// Polynomials along a straight reference space segment in Bernstein form.
+// Along x(s) = (1 - s) x0 + s x1 every linear factor of a 1D basis function
+// becomes (1 - s) l(x0) + s l(x1), so expanding the product of factors gives
+// the function's "scaled" Bernstein coefficients (binomials folded in). In
+// scaled form products of polynomials are plain convolutions, which keeps the
+// tensor product contraction cheap. Dividing out the binomials gives the
+// usual coefficients, whose signs bound the roots (convex hull property).
+
+
+const uint bern_max_degree = 3 * max_order;
+const uint bern_size       = bern_max_degree + 1;
+
+
+// scaled Bernstein coefficients (degree p) of 1D basis function "i" of order
+// p along x(s), Lagrange on equispaced nodes or monomial (SPEC_MONOMIAL)
+void basis_segment_bernstein(const in uint i, const in uint p,
+                             const in float x0, const in float x1,
+                             out float b[mop1])
+{
+  for (uint k = 0; k < mop1; ++k)
+    b[k] = 0.;
+
+  float w = 1.;
+  b[0]    = 1.;
+  uint nf = 0;  // factors multiplied in so far
+
+  for (uint j = 0; j < p + 1; ++j)
+  {
+    if (j == i && !SPEC_MONOMIAL)
+      continue;
+
+    float l0, l1;
+    if (SPEC_MONOMIAL)
+    {
+      if (j == 0)
+        continue;
+
+      // x^i is i factors of x and p - i factors of 1
+      l0 = j <= i ? x0 : 1.;
+      l1 = j <= i ? x1 : 1.;
+    }
+    else
+    {
+      float xj = float(j) / float(p);
+      float xi = float(i) / float(p);
+      l0       = x0 - xj;
+      l1       = x1 - xj;
+      w       /= xi - xj;
+    }
+
+    // b(z) *= l0 + z l1
+
+    ++nf;
+    for (uint k = nf; k > 0; --k)
+      b[k] = b[k] * l0 + b[k - 1] * l1;
+    b[0] *= l0;
+  }
+
+  for (uint k = 0; k < p + 1; ++k)
+    b[k] *= w;
+}
+
+// solution basis (order SPEC_P)
+void basis_segment_bernstein(const in uint i, const in float x0,
+                             const in float x1, out float b[mop1])
+{
+  basis_segment_bernstein(i, SPEC_P, x0, x1, b);
+}
+
+// binomial coefficients of degree n, the factors from usual to scaled form
+void bernstein_binomials(const in uint n, out float binom[mop1])
+{
+  binom[0] = 1.;
+  for (uint k = 0; k < n; ++k)
+    binom[k + 1] = binom[k] * float(n - k) / float(k + 1);
+}
+
+// scaled to usual coefficients
+void bernstein_unscale(const in uint n, inout float c[bern_size])
+{
+  float binom = 1.;
+  for (uint k = 0; k <= n; ++k)
+  {
+    c[k] /= binom;
+    binom = binom * float(n - k) / float(k + 1);
+  }
+}
+
+// coefficients of the same polynomial over [a, b] of the current interval
+// (de Casteljau, left part at b then right part at a / b)
+void bernstein_restrict(const in uint n, const in float a, const in float b,
+                        inout float c[bern_size])
+{
+  for (uint r = 1; r <= n; ++r)
+    for (uint k = n; k >= r; --k)
+      c[k] = (1. - b) * c[k - 1] + b * c[k];
+
+  float tau = b > 0. ? a / b : 0.;
+  for (uint r = 1; r <= n; ++r)
+    for (uint k = 0; k <= n - r; ++k)
+      c[k] = (1. - tau) * c[k] + tau * c[k + 1];
+}
+
+bool bernstein_sign_change(const in uint n, const in float c[bern_size])
+{
+  bool pos = false, neg = false;
+  for (uint k = 0; k <= n; ++k)
+  {
+    pos = pos || c[k] >= 0.;
+    neg = neg || c[k] <= 0.;
+  }
+  return pos && neg;
+}
+
+// root estimate in an interval from its end values, which are the end
+// coefficients of its restricted form
+float bernstein_interval_root(const in uint n, const in vec2 span,
+                              const in float cs[bern_size])
+{
+  float f0 = cs[0], f1 = cs[n];
+  float u  = f0 != f1 ? clamp(f0 / (f0 - f1), 0., 1.) : 0.5;
+  return mix(span.x, span.y, u);
+}
+
+// First root in [0, 1] of a polynomial in (usual) Bernstein form. Intervals
+// whose coefficients share a sign hold no root and are dropped, the rest are
+// halved front to back until they are "s_tol" wide. Returns -1 if none.
+//
+// Sign changes without a root can take several halvings per level to clear,
+// the budget grows with the depth and degree accordingly. Should it still run
+// out, the front-most interval left with a sign change is taken rather than
+// dropping the hit.
+float bernstein_first_root(const in uint n, const in float c[bern_size],
+                           const in float s_tol)
+{
+  const uint max_depth = 24;
+  uint       max_iter  = max_depth * 2 * (n + 1);
+
+  vec2 stack[max_depth + 1];
+  uint top = 0;
+  stack[top++] = vec2(0., 1.);
+
+  for (uint iter = 0; iter < max_iter && top > 0; ++iter)
+  {
+    vec2 span = stack[--top];
+
+    float cs[bern_size] = c;
+    bernstein_restrict(n, span.x, span.y, cs);
+
+    if (!bernstein_sign_change(n, cs))
+      continue;
+
+    if (span.y - span.x < s_tol || top + 2 > max_depth)
+      return bernstein_interval_root(n, span, cs);
+
+    float mid    = 0.5 * (span.x + span.y);
+    stack[top++] = vec2(mid, span.y);
+    stack[top++] = vec2(span.x, mid);
+  }
+
+  // out of budget, the stack top is the front-most interval
+
+  while (top > 0)
+  {
+    vec2 span = stack[--top];
+
+    float cs[bern_size] = c;
+    bernstein_restrict(n, span.x, span.y, cs);
+
+    if (bernstein_sign_change(n, cs))
+      return bernstein_interval_root(n, span, cs);
+  }
+
+  return -1.;
+}
+
+#endif
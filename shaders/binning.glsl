@@ -0,0 +1,91 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_BINNING
+#define SHDR_BINNING
+
+
+// Screen tile element binning. Once per frame every element bounding box is
+// projected to the screen and the element is listed in each tile its
+// projection overlaps:
+//
+//   bin_count - per element tile rectangle and view depth range, per tile
+//               candidate counts and near / far view depth bounds
+//   bin_scan  - exclusive prefix sum of the tile counts into list offsets
+//   bin_fill  - scatter element numbers into the tile lists
+//   bin_sort  - sort each tile list by the candidates' near view depth
+//
+// Rays of a binned tile then intersect only the tile's candidates inside the
+// tile's depth range, front to back, instead of traversing the k-d tree from
+// the root. Tiles whose list doesn't fit in tile_elems[] or is too long to
+// sort are flagged and fall back to the k-d tree.
+
+
+#include "data_structures.glsl"
+#include "raycast_interface_layout.glsl"
+#include "raycast_target.glsl"
+
+
+const uint bin_tile_size = 8;    // must match the raycast tiles
+const uint bin_width     = 64;   // local size of the per element kernels
+const uint bin_sort_max  = 1024; // longest list bin_sort handles
+
+layout(std430, set = 3, binding = 0) buffer tcount_data  { uint tile_counts[];  };
+layout(std430, set = 3, binding = 1) buffer toffset_data { uint tile_offsets[]; };
+layout(std430, set = 3, binding = 2) buffer tfill_data   { uint tile_fill[];    };
+layout(std430, set = 3, binding = 3) buffer tnear_data   { uint tile_near[];    };
+layout(std430, set = 3, binding = 4) buffer tfar_data    { uint tile_far[];     };
+layout(std430, set = 3, binding = 5) buffer telem_data   { int  tile_elems[];   };
+layout(std430, set = 3, binding = 6) buffer erect_data   { ivec4 elem_rects[];  };
+layout(std430, set = 3, binding = 7) buffer edepth_data  { vec2 elem_depth[];   };
+
+
+uvec2 bin_grid()
+{
+  return (uvec2(imageSize(render_target)) + bin_tile_size - 1) / bin_tile_size;
+}
+
+uint bin_index(const in uvec2 tile)
+{
+  return tile.y * bin_grid().x + tile.x;
+}
+
+// lists that were filled completely and bin_sort ordered front to back
+bool bin_sortable(const in uint first, const in uint count)
+{
+  return first + count <= uint(tile_elems.length()) && count <= bin_sort_max;
+}
+
+// Depths are stored as float bits for the atomic min / max, they are clamped
+// to be non negative so the bit patterns order like the values.
+uint depth_bits(const in float depth)
+{
+  return floatBitsToUint(max(depth, 0.));
+}
+
+float view_depth(const in vec3 p)
+{
+  return -(ubo.view * vec4(p, 1.)).z;
+}
+
+// rate of change of view depth along a ray direction
+float view_depth_rate(const in vec3 rd)
+{
+  return -(mat3(ubo.view) * rd).z;
+}
+
+
+#endif
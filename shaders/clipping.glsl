@@ -0,0 +1,113 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+
+#ifndef SHDR_CLIPPING
+#define SHDR_CLIPPING
+
+
+#include "raycast_interface_layout.glsl"
+
+#include "constants.glsl"
+#include "intersections.glsl"
+
+
+// The clip region is the intersection of up to four half spaces
+// dot(n, p) <= d, stored as (n, d), and optionally a box. Being convex it
+// cuts a ray to a single segment. Traversals start from that segment, so a
+// k-d subtree is only entered when its node box overlaps the region along the
+// ray and clipped subtrees cost nothing instead of being traced and then
+// discarded per pixel. Elements are then culled against the region by their
+// boxes and hits outside it are rejected.
+
+
+// Ray segment inside both the box and the clip region, (-1, -1) if empty.
+vec2 clipped_aabb_intersect(const in vec3 ro, const in vec3 rd,
+                            const in aabb box)
+{
+  vec2 seg = aabb_intersect(ro, rd, box);
+  if (seg.x == -1. && seg.y == -1.)
+  {
+    return seg;
+  }
+
+  if (ubo.clip_box_on != 0)
+  {
+    aabb clip_box;
+    clip_box.l = ubo.clip_box_l.xyz;
+    clip_box.h = ubo.clip_box_h.xyz;
+
+    vec2 box_seg = aabb_intersect(ro, rd, clip_box);
+    if (box_seg.x == -1. && box_seg.y == -1.)
+    {
+      return vec2(-1.);
+    }
+    seg = vec2(max(seg.x, box_seg.x), min(seg.y, box_seg.y));
+  }
+
+  for (uint i = 0; i < ubo.nclip_planes; ++i)
+  {
+    vec3  n     = ubo.clip_planes[i].xyz;
+    float depth = dot(n, ro) - ubo.clip_planes[i].w;  // > 0 outside
+    float rate  = dot(n, rd);
+
+    if (abs(rate) < FLT_EPSILON)
+    {
+      if (depth > 0.)
+        return vec2(-1.);
+      continue;
+    }
+
+    float t = -depth / rate;
+    if (rate > 0.)
+      seg.y = min(seg.y, t);
+    else
+      seg.x = max(seg.x, t);
+  }
+
+  if (seg.x > seg.y || seg.y < 0.)
+  {
+    return vec2(-1.);
+  }
+
+  return seg;
+}
+
+// Point test for hits found without a clipped segment, points on the region's
+// boundary (a slice lying in a clip plane) are kept.
+bool clip_visible(const in vec3 p)
+{
+  float tol = 1e-5 * length(domain_bbox.h - domain_bbox.l);
+
+  if (ubo.clip_box_on != 0 &&
+      (any(lessThan(p, ubo.clip_box_l.xyz - tol)) ||
+       any(greaterThan(p, ubo.clip_box_h.xyz + tol))))
+  {
+    return false;
+  }
+
+  for (uint i = 0; i < ubo.nclip_planes; ++i)
+  {
+    if (dot(ubo.clip_planes[i].xyz, p) > ubo.clip_planes[i].w + tol)
+      return false;
+  }
+
+  return true;
+}
+
+
+#endif
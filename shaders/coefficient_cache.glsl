@@ -0,0 +1,64 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_COEFFICIENT_CACHE
+#define SHDR_COEFFICIENT_CACHE
+
+
+// Workgroup shared copy of one element's nodal and state coefficients. This
+// must be included before mapping.glsl, it redirects the coefficient access
+// macros there to the cache so every evaluation in the workgroup (Newton steps
+// during intersection as well as shading) reads shared memory instead of the
+// node and state buffers. The element argument of the macros is ignored, the
+// caller is responsible for only evaluating the element last passed to
+// cache_element.
+
+
+#include "raycast_interface_layout.glsl"
+#include "specialization.glsl"
+
+
+shared float cached_nodes[3 * SPEC_NBFQ];
+shared float cached_state[5 * SPEC_NBFP];
+
+#define MAPPING_NODE(elem, i)           \
+  vec3(cached_nodes[3 * (i) + 0],       \
+       cached_nodes[3 * (i) + 1],       \
+       cached_nodes[3 * (i) + 2])
+
+#define MAPPING_STATE(elem, r, i) cached_state[SPEC_NBFP * (r) + (i)]
+
+
+// Cooperative strided load of an element's coefficients, every invocation of
+// the workgroup must call this and the caller must barrier() before use.
+void cache_element(const in int elem)
+{
+  uint lane    = gl_LocalInvocationIndex;
+  uint nthread = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+
+  for (uint i = lane; i < 3 * SPEC_NBFQ; i += nthread)
+  {
+    cached_nodes[i] = nodes[3 * SPEC_NBFQ * uint(elem) + i];
+  }
+
+  for (uint i = lane; i < 5 * SPEC_NBFP; i += nthread)
+  {
+    cached_state[i] = U[5 * SPEC_NBFP * uint(elem) + i];
+  }
+}
+
+
+#endif
@@ -20,8 +20,15 @@
 #include "constants.glsl"
 #include "output.glsl"
 
-const float cmap_size     = 255.;
-const float inv_cmap_size = 1. / cmap_size;
+const float cmap_size = 255.;  // texel centers span [0.5, 255.5] / 256
+
+// the linear sampler interpolates between neighboring colormap entries
+vec3 sample_colormap(const in float intensity)
+{
+  float u = (clamp(intensity, 0., 1.) * cmap_size + 0.5) / (cmap_size + 1.);
+
+  return textureLod(cmap_texture, vec2(u, 0.5), 0.).rgb;
+}
 
 vec4 map_color(const in int output_num, const in float min, const in float max, 
                const in float state[5], const in float gamma)
@@ -30,26 +37,7 @@ vec4 map_color(const in int output_num, const in float min, const in float max,
 
   float val = eval_output(output_num, state, gamma);
 
-  // linearly interpolate color output
-
-  float intensity = clamp((val - min) / (max - min), 0., 1. - 2. * FLT_EPSILON);
-
-  uint indx_l = uint(floor(intensity * cmap_size));
-  uint indx_h = indx_l + 1;
-
-  float intensity_l  = float(indx_l) * inv_cmap_size;
-  float intensity_h  = intensity_l + inv_cmap_size;
-
-  float w_l = (intensity_h - intensity) * cmap_size;
-  float w_h = (intensity - intensity_l) * cmap_size;
-
-  vec3 color = vec3(
-    w_l * cmap[3 * indx_l + 0] + w_h * cmap[3 * indx_h + 0],
-    w_l * cmap[3 * indx_l + 1] + w_h * cmap[3 * indx_h + 1],
-    w_l * cmap[3 * indx_l + 2] + w_h * cmap[3 * indx_h + 2]
-  );
-
-  return vec4(color, 1.);
+  return vec4(sample_colormap((val - min) / (max - min)), 1.);
 }
 
 #endif
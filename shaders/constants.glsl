@@ -19,5 +19,6 @@
 
 #define FLT_MAX     3.402823466e+38
 #define FLT_EPSILON 1.19209289e-07
+#define INT_MAX     0x7fffffff
 
 #endif
@@ -40,4 +40,36 @@ struct kdnode
 };
 
 
+struct elem_inverse_map
+{
+  vec4 ij0;     // center inverse Jacobian columns (exact if affine), w is
+  vec4 ij1;     // the mapping's largest deviation from the linearization
+  vec4 ij2;     // along the x, y and z global axes
+  vec4 origin;  // global position of the reference origin, w = 1 if affine
+};
+
+
+struct wavefront_ray
+{
+  vec3  ro;
+  float tmin;         // current traversal segment
+  vec3  rd;
+  float tmax;
+  vec3  hit_pos;      // reference coordinates of the closest hit
+  float thit;
+  int   node;         // current k-d node, -1 once the ray is finished
+  uint  cursor;       // next element within the current leaf
+  int   elem;         // closest hit element, -1 if none
+  float domain_tmax;
+};
+
+struct temporal_hit
+{
+  vec3 pos;   // global hit position
+  int  elem;  // hit element, -1 if none
+  vec3 ref;   // reference coordinates of the hit
+  uint age;   // frames since the hit was last found by full traversal
+};
+
+
 #endif
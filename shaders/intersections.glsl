@@ -26,12 +26,9 @@
 // the appropriate ray based on the current model, view, projection transform.
 // The final ray is in model coordinates so pre-computed geometry partitioning
 // structures remain valid.
-void find_ray(in vec4 ndc_pos, in mat4 view, in mat4 proj,
-              out vec3 ro, out vec3 rd)
+void find_ray_inverse(in vec4 ndc_pos, in mat4 iview, in mat4 iproj,
+                      out vec3 ro, out vec3 rd)
 {
-  mat4 iview = inverse(view);
-  mat4 iproj = inverse(proj);
-
   vec4 ndc_near = ndc_pos;
   vec4 ndc_far  = ndc_pos;
   ndc_near.z    = -1.;  // near plane at z = -1 in normalized device coordinates
@@ -52,6 +49,12 @@ void find_ray(in vec4 ndc_pos, in mat4 view, in mat4 proj,
   rd = normalize(rd);
 }
 
+void find_ray(in vec4 ndc_pos, in mat4 view, in mat4 proj,
+              out vec3 ro, out vec3 rd)
+{
+  find_ray_inverse(ndc_pos, inverse(view), inverse(proj), ro, rd);
+}
+
 
 // axis aligned box centered at the origin intersection from Inigo Quilez
 vec2 boxIntersection(in vec3 ro, in vec3 rd, vec3 boxSize)
@@ -0,0 +1,108 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_INVERSE_MAP
+#define SHDR_INVERSE_MAP
+
+
+#include "basis.glsl"
+#include "constants.glsl"
+#include "data_structures.glsl"
+
+
+// Point location helpers backed by the per element data from metadata.comp.
+// Affine elements carry their constant inverse Jacobian so global to reference
+// mapping is a single matrix-vector product. Curved elements carry the global
+// positions of a coarse reference lattice which gives Newton a starting guess
+// near the answer. Includers declare the "elem_maps" and "elem_warm" buffers.
+
+
+const uint warm_table_n    = 3;  // lattice points in each direction
+const uint warm_table_size = warm_table_n * warm_table_n * warm_table_n;
+
+
+vec3 warm_table_ref(const in uint i)
+{
+  uint ix, iy, iz;
+  split3(i, warm_table_n, ix, iy, iz);
+
+  return (vec3(ix, iy, iz) + 0.5) / float(warm_table_n);
+}
+
+
+bool elem_affine(const in int elem)
+{
+  return elem_maps[elem].origin.w != 0.;
+}
+
+mat3 elem_inverse_jacobian(const in int elem)
+{
+  return mat3(elem_maps[elem].ij0.xyz,
+              elem_maps[elem].ij1.xyz,
+              elem_maps[elem].ij2.xyz);
+}
+
+vec3 affine_glo2ref(const in vec3 g_pos, const in int elem)
+{
+  return elem_inverse_jacobian(elem) * (g_pos - elem_maps[elem].origin.xyz);
+}
+
+// How far the true reference position of a global point in the element can
+// lie from its center linearization, along each reference axis. The
+// linearization error stored with the inverse Jacobian bounds the global
+// residual, the inverse Jacobian maps it to reference space.
+vec3 elem_ref_pad(const in int elem)
+{
+  vec3 lin_err = vec3(elem_maps[elem].ij0.w,
+                      elem_maps[elem].ij1.w,
+                      elem_maps[elem].ij2.w);
+
+  return mat3(abs(elem_maps[elem].ij0.xyz),
+              abs(elem_maps[elem].ij1.xyz),
+              abs(elem_maps[elem].ij2.xyz)) * lin_err;
+}
+
+// maps a ray to reference space, the ray parameter is unchanged
+void affine_ray2ref(const in vec3 ro, const in vec3 rd, const in int elem,
+                    out vec3 ro_ref, out vec3 rd_ref)
+{
+  mat3 ij = elem_inverse_jacobian(elem);
+
+  ro_ref = ij * (ro - elem_maps[elem].origin.xyz);
+  rd_ref = ij * rd;
+}
+
+// Starting reference guess from the element's warm start table. The center
+// linearization picks the lattice cell directly, its lattice point's true
+// global position then corrects the guess with one linearized step.
+vec3 warm_start(const in vec3 g_pos, const in int elem)
+{
+  const uint n = warm_table_n;
+
+  vec3  r_lin = clamp(affine_glo2ref(g_pos, elem), vec3(0.), vec3(1.));
+  uvec3 cell  = min(uvec3(r_lin * float(n)), uvec3(n - 1));
+  uint  i     = n * (n * cell.z + cell.y) + cell.x;
+
+  vec3 g_lattice = elem_warm[warm_table_size * elem + i].xyz;
+  vec3 r_pos     = warm_table_ref(i) +
+                   elem_inverse_jacobian(elem) * (g_pos - g_lattice);
+
+  return clamp(r_pos, vec3(0.), vec3(1.));
+}
+
+
+#endif
@@ -0,0 +1,290 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_ISO_MESH
+#define SHDR_ISO_MESH
+
+
+// Isosurface triangle extraction (see source/iso_mesh.cpp). One workgroup per
+// element samples the output on a regular (subdiv + 1)^3 node grid over the
+// reference cube, from basis tables tabulated once at the nodes by
+// precomp_basis.comp, and marches the tetrahedra of the grid cells (six per
+// cell, all sharing its main diagonal). Every tetrahedron edge joins a node to
+// one of its 7 upper neighbors, so triangle vertices are named by the lower
+// node and that direction and are emitted once per element however many
+// tetrahedra share them.
+
+
+layout(local_size_x = 64) in;
+
+
+#include "constants.glsl"
+#include "data_structures.glsl"
+
+
+layout(std430, set = 0, binding = 0) buffer solver_params {
+  uint p;
+  uint q;
+  uint nelem;
+  uint etype;
+  uint dim;
+  uint nbfp;
+  uint nbfq;
+  float gamma;
+} params;
+layout(std430, set = 0, binding = 1) buffer geom_data {
+  float nodes[];
+};
+layout(std430, set = 0, binding = 2) buffer state_data {
+  float U[];
+};
+layout(std430, set = 0, binding = 3) buffer otbound_data {
+  vec2 otp_bounds[];
+};
+layout(std430, set = 0, binding = 4) buffer mesh_params_data {
+  uint  subdiv;
+  uint  niso;
+  float isovalues[8];
+} iso_params;
+layout(std430, set = 0, binding = 5) buffer basis_p_data {
+  float basis_p[];  // basis function major, (subdiv + 1)^3 nodes each
+};
+layout(std430, set = 0, binding = 6) buffer basis_q_data {
+  float basis_q[];
+};
+layout(std430, set = 0, binding = 7) buffer count_data {
+  uvec2 elem_counts[];  // (vertices, triangles), offsets for the emit pass
+};
+
+
+#include "mapping.glsl"
+#include "output.glsl"
+
+
+// must match iso_mesh_subdiv in source/iso_mesh.cpp
+const uint max_mesh_subdiv = 6;
+const uint max_mesh_nodes  =
+(max_mesh_subdiv + 1) * (max_mesh_subdiv + 1) * (max_mesh_subdiv + 1);
+
+shared float node_vals[max_mesh_nodes];
+
+
+// elements are spread over x and y workgroups, x is limited to 65535
+uint mesh_elem()
+{
+  return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
+
+// grid nodes along each reference axis
+uint mesh_side()
+{
+  return iso_params.subdiv + 1;
+}
+
+uint mesh_nodes()
+{
+  return mesh_side() * mesh_side() * mesh_side();
+}
+
+uint mesh_cells()
+{
+  return iso_params.subdiv * iso_params.subdiv * iso_params.subdiv;
+}
+
+uvec3 mesh_node_index(const in uint n)
+{
+  uvec3 i;
+  split3(n, mesh_side(), i.x, i.y, i.z);
+  return i;
+}
+
+vec3 mesh_node_ref(const in uint n)
+{
+  return vec3(mesh_node_index(n)) / float(iso_params.subdiv);
+}
+
+// the tables hold nodal basis values, monomial coefficients are evaluated
+// directly instead
+float mesh_node_output(const in uint elem, const in uint n)
+{
+  float state[5];
+  if (SPEC_MONOMIAL)
+  {
+    interp_state(mesh_node_ref(n), int(elem), state);
+  }
+  else
+  {
+    for (uint r = 0; r < 5; ++r)
+      state[r] = 0.;
+
+    for (uint bi = 0; bi < SPEC_NBFP; ++bi)
+    {
+      float phi = basis_p[bi * mesh_nodes() + n];
+      for (uint r = 0; r < 5; ++r)
+        state[r] += MAPPING_STATE(elem, r, bi) * phi;
+    }
+  }
+
+  return eval_output(SPEC_OUTPUT, state, params.gamma);
+}
+
+vec3 mesh_node_position(const in uint elem, const in uint n)
+{
+  if (SPEC_MONOMIAL)
+  {
+    return ref2glo(mesh_node_ref(n), elem);
+  }
+
+  vec3 g_pos = vec3(0.);
+  for (uint bi = 0; bi < SPEC_NBFQ; ++bi)
+    g_pos += MAPPING_NODE(elem, bi) * basis_q[bi * mesh_nodes() + n];
+
+  return g_pos;
+}
+
+// contours inside an output range, bit k set for contour k
+uint mesh_iso_mask(const in vec2 bounds)
+{
+  uint mask = 0;
+  for (uint k = 0; k < min(iso_params.niso, 8u); ++k)
+  {
+    float iso = iso_params.isovalues[k];
+    if (iso >= bounds.x && iso <= bounds.y)
+      mask |= 1u << k;
+  }
+  return mask;
+}
+
+// fills node_vals with the element's output at every grid node
+void sample_mesh_nodes(const in uint elem)
+{
+  for (uint n = gl_LocalInvocationIndex; n < mesh_nodes();
+       n += gl_WorkGroupSize.x)
+  {
+    node_vals[n] = mesh_node_output(elem, n);
+  }
+  barrier();
+}
+
+// node reached from "n" by the upper neighbor direction "dir" (bit a steps
+// along axis a), false if it leaves the grid
+bool mesh_step(const in uint n, const in uint dir, out uint m)
+{
+  uvec3 i = mesh_node_index(n) + uvec3(dir & 1u, (dir >> 1) & 1u, dir >> 2);
+  m       = (i.z * mesh_side() + i.y) * mesh_side() + i.x;
+  return all(lessThanEqual(i, uvec3(iso_params.subdiv)));
+}
+
+// lower node of grid cell "c"
+uint mesh_cell_base(const in uint c)
+{
+  uvec3 i;
+  split3(c, iso_params.subdiv, i.x, i.y, i.z);
+  return (i.z * mesh_side() + i.y) * mesh_side() + i.x;
+}
+
+// edge slot of the edge joining corners with direction bits "da" and "db"
+// (da a subset of db) of the cell at lower node "base"
+uint mesh_edge(const in uint base, const in uint da, const in uint db)
+{
+  uint lower;
+  mesh_step(base, da, lower);
+  return 7 * lower + ((da ^ db) - 1);
+}
+
+// corner direction bits of tetrahedron t of a cell, a monotone path from
+// corner 0 to corner 7 stepping along the axes in one of their 6 orders
+void mesh_tet(const in uint t, out uint bits[4])
+{
+  const uvec3 orders[6] = uvec3[6](
+  uvec3(0, 1, 2), uvec3(0, 2, 1), uvec3(1, 0, 2),
+  uvec3(1, 2, 0), uvec3(2, 0, 1), uvec3(2, 1, 0));
+
+  uvec3 o = orders[t];
+  bits[0] = 0u;
+  bits[1] = 1u << o.x;
+  bits[2] = bits[1] | (1u << o.y);
+  bits[3] = 7u;
+}
+
+// the tetrahedron's triangles for contour "iso", as edge slots (the second
+// triangle is only set when there are two)
+uint mesh_tet_triangles(const in uint base, const in uint t,
+                        const in float iso, out uvec3 tris[2])
+{
+  uint bits[4];
+  mesh_tet(t, bits);
+
+  uint inside = 0, ninside = 0;
+  for (uint c = 0; c < 4; ++c)
+  {
+    uint node;
+    mesh_step(base, bits[c], node);
+    if (node_vals[node] > iso)
+    {
+      inside |= 1u << c;
+      ++ninside;
+    }
+  }
+
+  if (ninside == 0 || ninside == 4)
+    return 0;
+
+  // corners ordered inside first, edges join corners i < j by bit subsets
+
+  uint c[4], ci = 0;
+  for (uint k = 0; k < 4; ++k)
+    if ((inside & (1u << k)) != 0) c[ci++] = k;
+  for (uint k = 0; k < 4; ++k)
+    if ((inside & (1u << k)) == 0) c[ci++] = k;
+
+  #define TET_EDGE(a, b) \
+  mesh_edge(base, bits[min(c[a], c[b])], bits[max(c[a], c[b])])
+
+  if (ninside == 2)
+  {
+    tris[0] = uvec3(TET_EDGE(0, 2), TET_EDGE(0, 3), TET_EDGE(1, 3));
+    tris[1] = uvec3(TET_EDGE(0, 2), TET_EDGE(1, 3), TET_EDGE(1, 2));
+    return 2;
+  }
+
+  // one corner separated from the other three
+
+  uint lone = ninside == 1 ? 0 : 3;
+  uint o0   = ninside == 1 ? 1 : 0;
+  tris[0]   = uvec3(TET_EDGE(lone, o0), TET_EDGE(lone, o0 + 1),
+                    TET_EDGE(lone, o0 + 2));
+
+  #undef TET_EDGE
+
+  return 1;
+}
+
+// whether the contour crosses edge slot "e" (7 per node), "a" and "b" are its
+// end nodes
+bool mesh_edge_crossed(const in uint e, const in float iso, out uint a,
+                       out uint b)
+{
+  a = e / 7;
+  if (!mesh_step(a, e % 7 + 1, b))
+    return false;
+
+  return (node_vals[a] > iso) != (node_vals[b] > iso);
+}
+
+
+#endif
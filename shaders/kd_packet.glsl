@@ -0,0 +1,218 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_KD_PACKET
+#define SHDR_KD_PACKET
+
+
+#include "constants.glsl"
+#include "data_structures.glsl"
+#include "intersections.glsl"
+#include "clipping.glsl"
+
+
+// The tree being traversed, modes that trace something other than elements
+// (boundary faces) point these at their own tree before the include.
+#ifndef KD_NODES
+#define KD_NODES      kdnodes
+#define KD_LEAF_ITEMS kdleafelems
+#endif
+
+
+// Packet k-d traversal, the rays of a subgroup descend the tree together.
+// Each lane keeps its own [tmin, tmax] segment (empty while it has no part in
+// the current subtree) but the current node and the stack of deferred far
+// children are shared, so node fetches and split decisions are made once per
+// packet and the tree only splits into both children where the packet does.
+// Lanes can only agree on near / far children if their directions share signs
+// on every axis, check packet_coherent before calling this. The includer
+// enables GL_KHR_shader_subgroup_vote and provides "intersect_elem".
+
+const int packet_stack_size = 24;  // must cover kdtree::max_depth
+
+
+bool packet_coherent(const in vec3 rd, const in bool active)
+{
+  bool coherent = true;
+  for (int a = 0; a < 3; ++a)
+  {
+    coherent = coherent && (subgroupAll(!active || rd[a] >  0.) ||
+                            subgroupAll(!active || rd[a] <= 0.));
+  }
+  return coherent;
+}
+
+// Every invocation of the subgroup must call this, lanes that aren't active
+// only ride along. Like kd_ray_traverse a ray ends at the first leaf it hits
+// something in.
+void kd_packet_traverse(const in vec3 ro, const in vec3 rd,
+                        const in bool active, out int elem_num,
+                        out bool hit_geom, out vec3 hit_pos, out float min_thit)
+{
+  elem_num = 0;
+  hit_geom = false;
+  hit_pos  = vec3(0.);
+  min_thit = FLT_MAX;
+
+  float tmin = 1., tmax = 0.;  // empty segment
+  if (active)
+  {
+    vec2 domain_bbox_intersect = clipped_aabb_intersect(ro, rd, domain_bbox);
+    if (!(domain_bbox_intersect.x == -1. && domain_bbox_intersect.y == -1.))
+    {
+      tmin = domain_bbox_intersect.x;
+      tmax = domain_bbox_intersect.y;
+    }
+  }
+
+  bool live = tmin <= tmax;
+  if (!subgroupAny(live))
+  {
+    return;
+  }
+
+  bvec3 dir_pos = bvec3(subgroupAny(live && rd.x > 0.),
+                        subgroupAny(live && rd.y > 0.),
+                        subgroupAny(live && rd.z > 0.));
+
+  const int missed_cache_size         = 8;
+  int missed_cache[missed_cache_size] = int[](-1, -1, -1, -1, -1, -1, -1, -1);
+  int missed_cache_head               = 0;
+
+  int   stack_node[packet_stack_size];
+  float stack_tmin[packet_stack_size];
+  float stack_tmax[packet_stack_size];
+  int   stack_top = 0;
+
+  int node_num = 0;
+
+  while (true)
+  {
+    // descend to the next leaf, node_num is uniform across the packet
+
+    kdnode node = KD_NODES[node_num];
+    while (node.offset == -1)
+    {
+      float thit = (node.split - ro[node.axis]) / rd[node.axis];
+
+      int near_node, far_node;
+      if (dir_pos[node.axis])
+      {
+        near_node = node_num + 1;
+        far_node  = node.child_r;
+      }
+      else
+      {
+        near_node = node.child_r;
+        far_node  = node_num + 1;
+      }
+
+      bool far_only  = live && thit < tmin;
+      bool near_only = live && !far_only && (thit > tmax || thit < 0.);
+
+      bool to_near = subgroupAny(live && !far_only);
+      bool to_far  = subgroupAny(live && !near_only);
+
+      if (to_near && to_far)  // packet diverges, defer the far child
+      {
+        if (stack_top < packet_stack_size)
+        {
+          bool far_part         = live && !near_only;
+          stack_node[stack_top] = far_node;
+          stack_tmin[stack_top] = far_part ? max(thit, tmin) : 1.;
+          stack_tmax[stack_top] = far_part ? tmax : 0.;
+          ++stack_top;
+        }
+
+        if (far_only)
+        {
+          live = false;
+        }
+        else if (live && !near_only)
+        {
+          tmax = thit;
+        }
+
+        node_num = near_node;
+      }
+      else if (to_near)
+      {
+        node_num = near_node;
+      }
+      else
+      {
+        node_num = far_node;
+      }
+
+      node = KD_NODES[node_num];
+    }
+
+    // intersect the leaf, element fetches are shared by the packet
+
+    float leaf_thit = FLT_MAX;
+    for (uint i = 0; i < node.count; ++i)
+    {
+      int test_elem = KD_LEAF_ITEMS[node.offset + i];
+
+      if (!live) { continue; }
+
+      bool already_missed = false;
+      for (uint ci = 0; ci < missed_cache_size; ++ci)
+      {
+        if (missed_cache[ci] == test_elem) { already_missed = true; break; }
+      }
+      if (already_missed) { continue; }
+
+      vec3 r_p; float thit = FLT_MAX;
+      bool hit = intersect_elem(ro, rd, test_elem, r_p, thit);
+
+      if (hit && thit < leaf_thit)
+      {
+        leaf_thit = thit;
+        min_thit  = thit;
+        hit_geom  = true;
+        hit_pos   = r_p;
+        elem_num  = test_elem;
+      }
+      else if (!hit)
+      {
+        missed_cache[missed_cache_head] = test_elem;
+        missed_cache_head = ((missed_cache_head + 1) % missed_cache_size);
+      }
+    }
+
+    // resume with the nearest deferred subtree some lane still needs
+
+    bool resumed = false;
+    while (stack_top > 0 && !resumed)
+    {
+      --stack_top;
+      node_num = stack_node[stack_top];
+      tmin     = stack_tmin[stack_top];
+      tmax     = stack_tmax[stack_top];
+      live     = !hit_geom && tmin <= tmax;
+      resumed  = subgroupAny(live);
+    }
+
+    if (!resumed)
+    {
+      break;
+    }
+  }
+}
+
+
+#endif
@@ -0,0 +1,115 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_KD_STEPPING
+#define SHDR_KD_STEPPING
+
+
+#include "data_structures.glsl"
+#include "intersections.glsl"
+
+
+// The tree being traversed, modes that trace something other than elements
+// (boundary faces) point these at their own tree before the include.
+#ifndef KD_NODES
+#define KD_NODES      kdnodes
+#define KD_LEAF_ITEMS kdleafelems
+#endif
+
+
+// Traversal is split into two steps so it can also run as separate wavefront
+// stages. A ray's traversal state is its current node and [tmin, tmax]
+// segment. kd_next_leaf descends from the current node to the next leaf
+// along the ray, kd_leave_leaf moves the segment past a leaf without hits and
+// climbs back to the first ancestor containing the remaining ray.
+
+bool kd_next_leaf(const in vec3 ro, const in vec3 rd,
+                  inout int node_num, inout float tmin, inout float tmax)
+{
+  uint failsafe = 0;
+  while (failsafe < 10000)
+  {
+    kdnode node = KD_NODES[node_num];
+
+    if (node.offset != -1)
+    {
+      return true;
+    }
+
+    float thit = (node.split - ro[node.axis]) / rd[node.axis];
+
+    int near_node, far_node;
+
+    if (rd[node.axis] > 0.)
+    {
+      near_node = node_num + 1;
+      far_node  = node.child_r;
+    }
+    else
+    {
+      near_node = node.child_r;
+      far_node  = node_num + 1;
+    }
+
+    if (thit < tmin)  // "far" child only
+    {
+      node_num = far_node;
+    }
+    else if (thit > tmax || thit < 0.)  // "near" child only
+    {
+      node_num = near_node;
+    }
+    else  // "both" children (far node handled by restarting)
+    {
+      node_num = near_node;
+      tmax     = thit;
+    }
+
+    ++failsafe;
+  }
+
+  return false;
+}
+
+bool kd_leave_leaf(const in vec3 ro, const in vec3 rd, const in float domain_tmax,
+                   inout int node_num, inout float tmin, inout float tmax)
+{
+  tmin = tmax + 1e-4;
+  tmax = domain_tmax;
+
+  if (tmin > domain_tmax)
+  {
+    return false;
+  }
+
+  // node_num = 0;  // restarting from root
+
+  bool hit_bbox;
+  do
+  {
+    node_num  = KD_NODES[node_num].parent;
+    vec2 test = aabb_intersect(ro, rd, KD_NODES[node_num].bbox);
+    hit_bbox  = !(test.x == -1. && test.y == -1.) &&
+                tmin >= test.x && tmin <= test.y;
+    tmax      = min(test.y, domain_tmax);
+  }
+  while (node_num > 0 && !hit_bbox);
+
+  return true;
+}
+
+
+#endif
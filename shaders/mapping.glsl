@@ -20,164 +20,331 @@
 
 
 #include "basis.glsl"
+#include "specialization.glsl"
 
 
-vec3 ref2glo(const in vec3 r_pos, const in uint elem, const in uint q)
-{
-  float phix[mop1], phiy[mop1], phiz[mop1];
+// Coefficient access. Includers may define these before including this file to
+// source element coefficients from somewhere other than the global node and
+// state buffers (the defaults index those buffers directly).
+
+#ifndef MAPPING_NODE
+#define MAPPING_NODE(elem, i)                      \
+  vec3(nodes[3 * SPEC_NBFQ * (elem) + 3 * (i) + 0], \
+       nodes[3 * SPEC_NBFQ * (elem) + 3 * (i) + 1], \
+       nodes[3 * SPEC_NBFQ * (elem) + 3 * (i) + 2])
+#endif
+
+#ifndef MAPPING_STATE
+#define MAPPING_STATE(elem, r, i) U[SPEC_NBFP * (5 * (elem) + (r)) + (i)]
+#endif
+
 
-  lagrange_lin(q, r_pos.x, phix);
-  lagrange_lin(q, r_pos.y, phiy);
-  lagrange_lin(q, r_pos.z, phiz);
+// Horner forms, used when the coefficients have been pre-transformed to tensor
+// monomial form (SPEC_MONOMIAL, see monomial_transform.comp). Each axis is
+// contracted from the highest power down, with derivatives carried alongside
+// the value in the usual Horner fashion.
 
-  uint qp1   = q + 1;
-  uint qp1p3 = qp1 * qp1 * qp1;
 
+vec3 ref2glo_horner(const in vec3 r_pos, const in uint elem)
+{
   vec3 g_pos = vec3(0.);
-  for (uint iz = 0; iz < qp1; ++iz)
+  for (int iz = int(SPEC_Q); iz >= 0; --iz)
+  {
+    vec3 sy = vec3(0.);
+    for (int iy = int(SPEC_Q); iy >= 0; --iy)
+    {
+      uint i  = SPEC_QP1 * (SPEC_QP1 * uint(iz) + uint(iy));
+      vec3 sx = vec3(0.);
+      for (int ix = int(SPEC_Q); ix >= 0; --ix)
+      {
+        sx = sx * r_pos.x + MAPPING_NODE(elem, i + uint(ix));
+      }
+      sy = sy * r_pos.y + sx;
+    }
+    g_pos = g_pos * r_pos.z + sy;
+  }
+
+  return g_pos;
+}
+
+
+void mapinfo_horner(const in vec3 r_pos, const in int elem, out vec3 g_pos,
+                    out mat3 j)
+{
+  vec3 g_x = vec3(0.), g_y = vec3(0.), g_z = vec3(0.);
+
+  g_pos = vec3(0.);
+  for (int iz = int(SPEC_Q); iz >= 0; --iz)
   {
-    for (uint iy = 0; iy < qp1; ++iy)
+    vec3 sy = vec3(0.), sy_x = vec3(0.), sy_y = vec3(0.);
+    for (int iy = int(SPEC_Q); iy >= 0; --iy)
     {
-      for (uint ix = 0; ix < qp1; ++ix)
+      uint i    = SPEC_QP1 * (SPEC_QP1 * uint(iz) + uint(iy));
+      vec3 sx   = vec3(0.);
+      vec3 sx_x = vec3(0.);
+      for (int ix = int(SPEC_Q); ix >= 0; --ix)
       {
-        uint i    = qp1 * qp1 * iz + qp1 * iy + ix;
-        vec3 node = vec3(nodes[3 * qp1p3 * elem + 3 * i + 0],
-                         nodes[3 * qp1p3 * elem + 3 * i + 1],
-                         nodes[3 * qp1p3 * elem + 3 * i + 2]);
+        sx_x = sx_x * r_pos.x + sx;
+        sx   = sx   * r_pos.x + MAPPING_NODE(elem, i + uint(ix));
+      }
+      sy_y = sy_y * r_pos.y + sy;
+      sy_x = sy_x * r_pos.y + sx_x;
+      sy   = sy   * r_pos.y + sx;
+    }
+    g_z   = g_z   * r_pos.z + g_pos;
+    g_x   = g_x   * r_pos.z + sy_x;
+    g_y   = g_y   * r_pos.z + sy_y;
+    g_pos = g_pos * r_pos.z + sy;
+  }
 
-        g_pos += node * (phix[ix] * phiy[iy] * phiz[iz]);
+  j = mat3(g_x, g_y, g_z);
+}
+
+
+void interp_state_horner(const in vec3 r_pos, const in int elem,
+                         out float state[5])
+{
+  for (uint ir = 0; ir < 5; ++ir)
+  {
+    float val = 0.;
+    for (int iz = int(SPEC_P); iz >= 0; --iz)
+    {
+      float sy = 0.;
+      for (int iy = int(SPEC_P); iy >= 0; --iy)
+      {
+        uint i   = SPEC_PP1 * (SPEC_PP1 * uint(iz) + uint(iy));
+        float sx = 0.;
+        for (int ix = int(SPEC_P); ix >= 0; --ix)
+        {
+          sx = sx * r_pos.x + MAPPING_STATE(elem, ir, i + uint(ix));
+        }
+        sy = sy * r_pos.y + sx;
       }
+      val = val * r_pos.z + sy;
     }
+    state[ir] = val;
+  }
+}
+
+
+void interp_state_grad_horner(const in vec3 r_pos, const in int elem,
+                              out float state[5],
+                              out float state_x[5],
+                              out float state_y[5],
+                              out float state_z[5])
+{
+  for (uint ir = 0; ir < 5; ++ir)
+  {
+    float val = 0., val_x = 0., val_y = 0., val_z = 0.;
+    for (int iz = int(SPEC_P); iz >= 0; --iz)
+    {
+      float sy = 0., sy_x = 0., sy_y = 0.;
+      for (int iy = int(SPEC_P); iy >= 0; --iy)
+      {
+        uint i     = SPEC_PP1 * (SPEC_PP1 * uint(iz) + uint(iy));
+        float sx   = 0.;
+        float sx_x = 0.;
+        for (int ix = int(SPEC_P); ix >= 0; --ix)
+        {
+          sx_x = sx_x * r_pos.x + sx;
+          sx   = sx   * r_pos.x + MAPPING_STATE(elem, ir, i + uint(ix));
+        }
+        sy_y = sy_y * r_pos.y + sy;
+        sy_x = sy_x * r_pos.y + sx_x;
+        sy   = sy   * r_pos.y + sx;
+      }
+      val_z = val_z * r_pos.z + val;
+      val_x = val_x * r_pos.z + sy_x;
+      val_y = val_y * r_pos.z + sy_y;
+      val   = val   * r_pos.z + sy;
+    }
+    state[ir]   = val;
+    state_x[ir] = val_x;
+    state_y[ir] = val_y;
+    state_z[ir] = val_z;
+  }
+}
+
+
+
+// All evaluations below are sum factorized: coefficients are streamed once in
+// storage order (x fastest) and contracted against the x basis, the partial
+// sums against y, then z. Derivatives share the partial sums of the value.
+// Monomial coefficients are dispatched to the Horner forms above.
+
+
+vec3 ref2glo(const in vec3 r_pos, const in uint elem)
+{
+  if (SPEC_MONOMIAL) return ref2glo_horner(r_pos, elem);
+
+  float phix[mop1], phiy[mop1], phiz[mop1];
+
+  lagrange_lin(SPEC_Q, r_pos.x, phix);
+  lagrange_lin(SPEC_Q, r_pos.y, phiy);
+  lagrange_lin(SPEC_Q, r_pos.z, phiz);
+
+  vec3 g_pos = vec3(0.);
+  for (uint iz = 0; iz < SPEC_QP1; ++iz)
+  {
+    vec3 sy = vec3(0.);
+    for (uint iy = 0; iy < SPEC_QP1; ++iy)
+    {
+      uint i  = SPEC_QP1 * (SPEC_QP1 * iz + iy);
+      vec3 sx = vec3(0.);
+      for (uint ix = 0; ix < SPEC_QP1; ++ix)
+      {
+        sx += MAPPING_NODE(elem, i + ix) * phix[ix];
+      }
+      sy += sx * phiy[iy];
+    }
+    g_pos += sy * phiz[iz];
   }
 
   return g_pos;
 }
 
 
-void mapinfo(const in vec3 r_pos, const in int elem, const in uint q,
-             out vec3 g_pos, out mat3 j)
+void mapinfo(const in vec3 r_pos, const in int elem, out vec3 g_pos,
+             out mat3 j)
 {
+  if (SPEC_MONOMIAL)
+  {
+    mapinfo_horner(r_pos, elem, g_pos, j);
+    return;
+  }
+
   float phix[mop1],   phiy[mop1],   phiz[mop1];
   float phix_x[mop1], phiy_y[mop1], phiz_z[mop1];
 
-  lagrange_lin(q, r_pos.x, phix);
-  lagrange_lin(q, r_pos.y, phiy);
-  lagrange_lin(q, r_pos.z, phiz);
+  lagrange_lin(SPEC_Q, r_pos.x, phix);
+  lagrange_lin(SPEC_Q, r_pos.y, phiy);
+  lagrange_lin(SPEC_Q, r_pos.z, phiz);
 
-  dlagrange_lin(q, r_pos.x, phix_x);
-  dlagrange_lin(q, r_pos.y, phiy_y);
-  dlagrange_lin(q, r_pos.z, phiz_z);
+  dlagrange_lin(SPEC_Q, r_pos.x, phix_x);
+  dlagrange_lin(SPEC_Q, r_pos.y, phiy_y);
+  dlagrange_lin(SPEC_Q, r_pos.z, phiz_z);
 
-  uint qp1   = q + 1;
-  uint qp1p3 = qp1 * qp1 * qp1;
+  vec3 g_x = vec3(0.), g_y = vec3(0.), g_z = vec3(0.);
 
   g_pos = vec3(0.);
-  j     = mat3(0.);
-  for (uint iz = 0; iz < qp1; ++iz)
+  for (uint iz = 0; iz < SPEC_QP1; ++iz)
   {
-    for (uint iy = 0; iy < qp1; ++iy)
+    vec3 sy = vec3(0.), sy_x = vec3(0.), sy_y = vec3(0.);
+    for (uint iy = 0; iy < SPEC_QP1; ++iy)
     {
-      for (uint ix = 0; ix < qp1; ++ix)
+      uint i    = SPEC_QP1 * (SPEC_QP1 * iz + iy);
+      vec3 sx   = vec3(0.);
+      vec3 sx_x = vec3(0.);
+      for (uint ix = 0; ix < SPEC_QP1; ++ix)
       {
-        uint i    = qp1 * qp1 * iz + qp1 * iy + ix;
-        vec3 node = vec3(nodes[3 * qp1p3 * elem + 3 * i + 0],
-                         nodes[3 * qp1p3 * elem + 3 * i + 1],
-                         nodes[3 * qp1p3 * elem + 3 * i + 2]);
-
-        g_pos += node * (phix[ix] * phiy[iy] * phiz[iz]);
-        j     += outerProduct(node,
-                              vec3(phix_x[ix] * phiy[iy]   * phiz[iz],
-                                   phix[ix]   * phiy_y[iy] * phiz[iz],
-                                   phix[ix]   * phiy[iy]   * phiz_z[iz]));
+        vec3 node = MAPPING_NODE(elem, i + ix);
+        sx   += node * phix[ix];
+        sx_x += node * phix_x[ix];
       }
+      sy   += sx   * phiy[iy];
+      sy_x += sx_x * phiy[iy];
+      sy_y += sx   * phiy_y[iy];
     }
+    g_pos += sy   * phiz[iz];
+    g_x   += sy_x * phiz[iz];
+    g_y   += sy_y * phiz[iz];
+    g_z   += sy   * phiz_z[iz];
   }
+
+  j = mat3(g_x, g_y, g_z);
 }
 
 
-void interp_state(const in vec3 r_pos, const in int elem, const in uint p, 
-                  out float state[5])
+void interp_state(const in vec3 r_pos, const in int elem, out float state[5])
 {
-  const uint pp1   = p + 1;
-  const uint pp1p3 = pp1 * pp1 * pp1;
+  if (SPEC_MONOMIAL)
+  {
+    interp_state_horner(r_pos, elem, state);
+    return;
+  }
 
   float phix[mop1], phiy[mop1], phiz[mop1];
 
-  lagrange_lin(p, r_pos.x, phix);
-  lagrange_lin(p, r_pos.y, phiy);
-  lagrange_lin(p, r_pos.z, phiz);
+  lagrange_lin(SPEC_P, r_pos.x, phix);
+  lagrange_lin(SPEC_P, r_pos.y, phiy);
+  lagrange_lin(SPEC_P, r_pos.z, phiz);
 
-  state = float[5](0., 0., 0., 0., 0.);
-  for (uint iz = 0; iz < pp1; ++iz)
+  for (uint ir = 0; ir < 5; ++ir)
   {
-    for (uint iy = 0; iy < pp1; ++iy)
+    float val = 0.;
+    for (uint iz = 0; iz < SPEC_PP1; ++iz)
     {
-      for (uint ix = 0; ix < pp1; ++ix)
+      float sy = 0.;
+      for (uint iy = 0; iy < SPEC_PP1; ++iy)
       {
-        uint i   = pp1 * pp1 * iz + pp1 * iy + ix;
-        float bf = phix[ix] * phiy[iy] * phiz[iz];
-
-        state[0] += U[pp1p3 * (5 * elem + 0) + i] * bf;
-        state[1] += U[pp1p3 * (5 * elem + 1) + i] * bf;
-        state[2] += U[pp1p3 * (5 * elem + 2) + i] * bf;
-        state[3] += U[pp1p3 * (5 * elem + 3) + i] * bf;
-        state[4] += U[pp1p3 * (5 * elem + 4) + i] * bf;
+        uint i   = SPEC_PP1 * (SPEC_PP1 * iz + iy);
+        float sx = 0.;
+        for (uint ix = 0; ix < SPEC_PP1; ++ix)
+        {
+          sx += MAPPING_STATE(elem, ir, i + ix) * phix[ix];
+        }
+        sy += sx * phiy[iy];
       }
+      val += sy * phiz[iz];
     }
+    state[ir] = val;
   }
 }
 
 
-void interp_state_grad(const in vec3 r_pos, const in int elem, const in uint p, 
+void interp_state_grad(const in vec3 r_pos, const in int elem,
                        out float state[5],
                        out float state_x[5], 
                        out float state_y[5], 
                        out float state_z[5])
 {
-  const uint pp1   = p + 1;
-  const uint pp1p3 = pp1 * pp1 * pp1;
+  if (SPEC_MONOMIAL)
+  {
+    interp_state_grad_horner(r_pos, elem, state, state_x, state_y, state_z);
+    return;
+  }
 
   float phix[mop1],   phiy[mop1],   phiz[mop1];
   float phix_x[mop1], phiy_y[mop1], phiz_z[mop1];
 
-  lagrange_lin(p, r_pos.x, phix);
-  lagrange_lin(p, r_pos.y, phiy);
-  lagrange_lin(p, r_pos.z, phiz);
+  lagrange_lin(SPEC_P, r_pos.x, phix);
+  lagrange_lin(SPEC_P, r_pos.y, phiy);
+  lagrange_lin(SPEC_P, r_pos.z, phiz);
 
-  dlagrange_lin(p, r_pos.x, phix_x);
-  dlagrange_lin(p, r_pos.y, phiy_y);
-  dlagrange_lin(p, r_pos.z, phiz_z);
+  dlagrange_lin(SPEC_P, r_pos.x, phix_x);
+  dlagrange_lin(SPEC_P, r_pos.y, phiy_y);
+  dlagrange_lin(SPEC_P, r_pos.z, phiz_z);
 
-  state   = float[5](0., 0., 0., 0., 0.);
-  state_x = float[5](0., 0., 0., 0., 0.);
-  state_y = float[5](0., 0., 0., 0., 0.);
-  state_z = float[5](0., 0., 0., 0., 0.);
-  for (uint iz = 0; iz < pp1; ++iz)
+  for (uint ir = 0; ir < 5; ++ir)
   {
-    for (uint iy = 0; iy < pp1; ++iy)
+    float val = 0., val_x = 0., val_y = 0., val_z = 0.;
+    for (uint iz = 0; iz < SPEC_PP1; ++iz)
     {
-      for (uint ix = 0; ix < pp1; ++ix)
+      float sy = 0., sy_x = 0., sy_y = 0.;
+      for (uint iy = 0; iy < SPEC_PP1; ++iy)
       {
-        uint i     = pp1 * pp1 * iz + pp1 * iy + ix;
-
-        float bf   = phix[ix] * phiy[iy] * phiz[iz];
-
-        float bf_x = phix_x[ix] * phiy[iy] * phiz[iz];
-        float bf_y = phix[ix] * phiy_y[iy] * phiz[iz];
-        float bf_z = phix[ix] * phiy[iy] * phiz_z[iz];
-
-        for (uint ir = 0; ir < 5; ++ir)
+        uint i     = SPEC_PP1 * (SPEC_PP1 * iz + iy);
+        float sx   = 0.;
+        float sx_x = 0.;
+        for (uint ix = 0; ix < SPEC_PP1; ++ix)
         {
-          float coeff = U[pp1p3 * (5 * elem + ir) + i];
-
-          state[ir]   += coeff * bf;
-
-          state_x[ir] += coeff * bf_x;
-          state_y[ir] += coeff * bf_y;
-          state_z[ir] += coeff * bf_z;
+          float coeff = MAPPING_STATE(elem, ir, i + ix);
+          sx   += coeff * phix[ix];
+          sx_x += coeff * phix_x[ix];
         }
+        sy   += sx   * phiy[iy];
+        sy_x += sx_x * phiy[iy];
+        sy_y += sx   * phiy_y[iy];
       }
+      val   += sy   * phiz[iz];
+      val_x += sy_x * phiz[iz];
+      val_y += sy_y * phiz[iz];
+      val_z += sy   * phiz_z[iz];
     }
+    state[ir]   = val;
+    state_x[ir] = val_x;
+    state_y[ir] = val_y;
+    state_z[ir] = val_z;
   }
 }
 
@@ -19,14 +19,53 @@
 #define OUTPUT_HEADER
 
 
+// Outputs that are a ratio of two state components (numer / denom, denom = -1
+// for a single component), their isosurfaces are where a linear combination
+// of the state vanishes. Returns false for other outputs. eval_output reads
+// these from here so the subcell bounds and exact roots relying on the table
+// can't drift from the rendered output.
+bool output_ratio(const in int output_num, out uint numer, out int denom)
+{
+  numer = 0;
+  denom = -1;
+
+  switch (output_num)
+  {
+    case 0:  // mach (TODO: change back later, see eval_output)
+      numer = 1; denom = 0;
+      return true;
+    case 1:  // density
+      numer = 0; denom = -1;
+      return true;
+    case 2:  // x velocity
+      numer = 1; denom = 0;
+      return true;
+    case 3:  // y velocity
+      numer = 2; denom = 0;
+      return true;
+    case 4:  // z velocity
+      numer = 3; denom = 0;
+      return true;
+  }
+
+  return false;
+}
+
+
 float eval_output(const in int output_num, const in float state[5],
                   const in float gamma)
 {
+  uint numer; int denom;
+  if (output_ratio(output_num, numer, denom))
+  {
+    return denom >= 0 ? state[numer] / state[uint(denom)] : state[numer];
+  }
+
   float output_val = 0.;
 
   switch (output_num)
   {
-    case 0:  // mach (TODO: change back later)
+    case 0:  // mach, once restored output_ratio must stop listing it
       {
         // float u    = state[1] / state[0];
         // float v    = state[2] / state[0];
@@ -35,22 +74,8 @@ float eval_output(const in int output_num, const in float state[5],
         // float p    = (gamma - 1.) * (state[4] - 0.5 * s * s);
         // float c    = sqrt(gamma * p / state[0]);
         // output_val = s / c;
-
-        output_val = state[1] / state[0];
       }
       break;
-    case 1:   // density
-      output_val = state[0];
-      break;
-    case 2:   // x velocity
-      output_val = state[1] / state[0];
-      break;
-    case 3:   // y velocity
-      output_val = state[2] / state[0];
-      break;
-    case 4:   // z velocity
-      output_val = state[3] / state[0];
-      break;
   }
 
   return output_val;
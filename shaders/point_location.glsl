@@ -0,0 +1,156 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_POINT_LOCATION
+#define SHDR_POINT_LOCATION
+
+
+#include "intersections.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+
+
+// Point location, shared by the modes that sample the field at points (slice,
+// slice set and volume).
+
+// reference coordinates of a global point if it lies in the element
+bool point_in_elem(const in vec3 p, const in int elem_num, out vec3 r_p)
+{
+  if (!inside_aabb(p, bboxes[elem_num]))
+  {
+    return false;
+  }
+
+  const float hit_tol  = 1e-3;
+        float step_tol = 1e-5 * ubo.tol_scale;
+        uint max_steps = ubo.slice_steps;
+
+  if (elem_affine(elem_num))
+  {
+    r_p = affine_glo2ref(p, elem_num);
+  }
+  else
+  {
+    r_p = warm_start(p, elem_num);
+    for (uint step = 0; step < max_steps; ++step)
+    {
+      mat3 j;
+      vec3 g_p;
+      mapinfo(r_p, elem_num, g_p, j);
+
+      vec3 dr_p = inverse(j) * (g_p - p);
+      r_p      -= dr_p;
+
+      if (dot(dr_p, dr_p) < step_tol * step_tol) break;
+    }
+  }
+
+  if (r_p.x > 0. - hit_tol && r_p.x < 1. + hit_tol && 
+      r_p.y > 0. - hit_tol && r_p.y < 1. + hit_tol && 
+      r_p.z > 0. - hit_tol && r_p.z < 1. + hit_tol)
+  {
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+
+// Descends the element k-d tree to the leaf holding a global point.
+int locate_leaf(const in vec3 p)
+{
+  int node_num = 0;
+
+  uint failsafe = 0;
+  while (failsafe < 500 && kdnodes[node_num].offset == -1)
+  {
+    kdnode node = kdnodes[node_num];
+
+    if (p[node.axis] <= node.split)
+    {
+      node_num = node_num + 1;
+    }
+    else
+    {
+      node_num = node.child_r;
+    }
+
+    ++failsafe;
+  }
+
+  return node_num;
+}
+
+// finds the element of a leaf containing a global point
+bool locate_in_leaf(const in vec3 p, const in int node_num, out int elem_num,
+                    out vec3 r_p)
+{
+  elem_num    = 0;
+  r_p         = vec3(0.);
+  kdnode node = kdnodes[node_num];
+
+  for (uint i = 0; i < node.count; ++i)
+  {
+    int test_elem = kdleafelems[node.offset + i];
+    if (point_in_elem(p, test_elem, r_p))
+    {
+      elem_num = test_elem;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool locate_point(const in vec3 p, out int elem_num, out vec3 r_p)
+{
+  return locate_in_leaf(p, locate_leaf(p), elem_num, r_p);
+}
+
+// Locates a point near the previous one located, trying the previous element
+// ("elem_num", -1 if none) and then the rest of its leaf ("leaf_num", -1 if
+// none) before descending the tree again. Both are updated on success.
+bool locate_point_near(const in vec3 p, inout int leaf_num, inout int elem_num,
+                       out vec3 r_p)
+{
+  if (elem_num != -1 && point_in_elem(p, elem_num, r_p))
+  {
+    return true;
+  }
+
+  int found;
+  if (leaf_num != -1 && locate_in_leaf(p, leaf_num, found, r_p))
+  {
+    elem_num = found;
+    return true;
+  }
+
+  int leaf = locate_leaf(p);
+  if (leaf != leaf_num && locate_in_leaf(p, leaf, found, r_p))
+  {
+    leaf_num = leaf;
+    elem_num = found;
+    return true;
+  }
+
+  return false;
+}
+
+
+#endif
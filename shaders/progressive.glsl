@@ -0,0 +1,52 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_PROGRESSIVE
+#define SHDR_PROGRESSIVE
+
+
+// Progressive refinement. The render image is split into blocks of
+// 2^block_log2 pixels on a side and each frame traces one pixel per block,
+// stepping through the block in a bit reversed Morton order so early samples
+// are spread out. accum[] keeps every traced color (alpha 1, alpha 0 marks a
+// pixel not traced since the last reset) and untraced pixels show the nearest
+// traced one of their block. Step 0 resets the accumulation, so a moving
+// camera renders one ray per block and a still one converges to one ray per
+// pixel after a block's worth of frames.
+
+
+layout(std430, set = 3, binding = 0) buffer accum_data { vec4 accum[]; };
+
+layout(push_constant) uniform progressive_constants {
+  uint step;        // samples already accumulated, tracing stops at nsample
+  uint block_log2;  // at most 3, blocks must not straddle screen tiles
+} pc;
+
+
+// Offset within its block of the pixel traced at a given step.
+uvec2 progressive_offset(const in uint step, const in uint block_log2)
+{
+  if (block_log2 == 0)
+    return uvec2(0);
+
+  uint m = bitfieldReverse(step) >> (32 - 2 * block_log2);
+  uint x = (m & 1u) | ((m >> 1) & 2u) | ((m >> 2) & 4u);
+  uint y = ((m >> 1) & 1u) | ((m >> 2) & 2u) | ((m >> 3) & 4u);
+  return uvec2(x, y);
+}
+
+
+#endif
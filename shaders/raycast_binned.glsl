@@ -0,0 +1,148 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_BINNED
+#define SHDR_RAYCAST_BINNED
+
+
+// Binned compute entry point shared by the raycast_*_binned.comp shaders. The
+// includer provides "intersect_elem", "shade_hit" and "raycast" through one of
+// the raycast_<mode>.glsl files.
+//
+// Instead of traversing the k-d tree each ray intersects the candidate list of
+// its screen tile (see binning.glsl). The list is sorted by near view depth
+// and staged through shared memory a workgroup's worth at a time. Rays are
+// clipped to the tile's view depth range and stop at the first candidate
+// starting behind their closest hit so far. Tiles without candidates are
+// cleared outright, tiles whose list overflowed or went unsorted use the
+// regular k-d tree raycast.
+
+
+#include "constants.glsl"
+#include "raycast_tile.glsl"
+#include "clipping.glsl"
+#include "binning.glsl"
+
+
+const uint bin_stage = 64;  // candidates staged per round, the workgroup size
+
+shared int   staged_elem[bin_stage];
+shared float staged_depth[bin_stage];
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  uint ti       = bin_index(tile);
+  uint count    = tile_counts[ti];
+  uint first    = tile_offsets[ti];
+  bool overflow = !bin_sortable(first, count);
+
+  // invocations outside the image stay along for the barriers below
+
+  bool inside = pixel.x < uint(size.x) && pixel.y < uint(size.y);
+  vec4 color  = clear_color;
+  bool live   = false;
+
+  vec3  ro = vec3(0.), rd = vec3(0.);
+  float depth_ro = 0., depth_rate = 1.;
+
+  if (inside && !tile_culled && count > 0)
+  {
+    find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview,
+                     tile_iproj, ro, rd);
+
+    if (overflow)
+    {
+      color = raycast(ro, rd);
+    }
+    else
+    {
+      vec2 domain_intersect = clipped_aabb_intersect(ro, rd, domain_bbox);
+      if (!(domain_intersect.x == -1. && domain_intersect.y == -1.))
+      {
+        depth_ro   = view_depth(ro);
+        depth_rate = max(view_depth_rate(rd), FLT_EPSILON);
+
+        float tnear = (uintBitsToFloat(tile_near[ti]) - depth_ro) / depth_rate;
+        float tfar  = (uintBitsToFloat(tile_far[ti])  - depth_ro) / depth_rate;
+
+        live = max(domain_intersect.x, tnear) <= min(domain_intersect.y, tfar);
+      }
+    }
+  }
+
+  vec3  hit_pos  = vec3(0.);
+  float hit_t    = FLT_MAX;
+  int   hit_elem = -1;
+
+  if (!overflow)  // uniform across the tile
+  {
+    for (uint base = 0; base < count; base += bin_stage)
+    {
+      uint lid = gl_LocalInvocationIndex;
+      if (base + lid < count)
+      {
+        int elem          = tile_elems[first + base + lid];
+        staged_elem[lid]  = elem;
+        staged_depth[lid] = elem_depth[elem].x;
+      }
+      barrier();
+
+      uint nstaged = min(bin_stage, count - base);
+      for (uint k = 0; live && k < nstaged; ++k)
+      {
+        // every later candidate starts further back
+
+        if ((staged_depth[k] - depth_ro) / depth_rate > hit_t)
+        {
+          live = false;
+          break;
+        }
+
+        int  elem_num = staged_elem[k];
+        vec3 r_p; float thit = FLT_MAX;
+        bool hit = intersect_elem(ro, rd, elem_num, r_p, thit);
+
+        if (hit && thit < hit_t)
+        {
+          hit_t    = thit;
+          hit_pos  = r_p;
+          hit_elem = elem_num;
+        }
+      }
+      barrier();
+    }
+
+    if (hit_elem >= 0)
+    {
+      color = shade_hit(ro, rd, hit_elem, hit_pos, hit_t);
+    }
+  }
+
+  if (inside)
+  {
+    imageStore(render_target, ivec2(pixel), color);
+  }
+}
+
+
+#endif
@@ -0,0 +1,190 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_BOUNDARY
+#define SHDR_RAYCAST_BOUNDARY
+
+
+// Boundary face mode, the surface mode restricted to what can actually be
+// seen. Only exterior element faces are visible from outside the domain, so
+// rays traverse a k-d tree over those faces (extracted at load time, see
+// source/boundary_faces.cpp) and solve for the two free reference coordinates
+// of each candidate face instead of marching through element volumes. The
+// items the traversal returns are face numbers, shade_hit maps them back to
+// their elements.
+
+
+#define KD_NODES      face_kdnodes
+#define KD_LEAF_ITEMS face_kdleaffaces
+
+#include "raycast_interface_layout.glsl"
+
+#include "constants.glsl"
+#include "intersections.glsl"
+#include "clipping.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+#include "colormapping.glsl"
+
+
+int face_elem(const in int face_num)
+{
+  return faces[face_num] / 6;
+}
+
+// Newton on the two free reference coordinates of face "face" of an element,
+// starting from the guess in r_p (whose fixed coordinate must already be set).
+// The ray is where two planes through it meet, so a face point on both planes
+// is a hit. Returns whether the squared plane distance dropped below tol2, r_p
+// and its global position g_p hold the last iterate either way.
+bool face_newton(const in vec3 ro, const in vec3 rd, const in int elem_num,
+                 const in int face, const in uint max_steps,
+                 const in float tol2, inout vec3 r_p, out vec3 g_p)
+{
+  int b = (face / 2 + 1) % 3;
+  int c = (face / 2 + 2) % 3;
+
+  vec3 ax = abs(rd.x) < 0.9 * length(rd) ? vec3(1., 0., 0.) : vec3(0., 1., 0.);
+  vec3 n1 = normalize(cross(rd, ax));
+  vec3 n2 = normalize(cross(rd, n1));
+
+  for (uint step = 0; step < max_steps; ++step)
+  {
+    mat3 j;
+    mapinfo(r_p, elem_num, g_p, j);
+
+    vec2 dist = vec2(dot(n1, g_p - ro), dot(n2, g_p - ro));
+    if (dot(dist, dist) < tol2)
+    {
+      return true;
+    }
+
+    mat2 jf  = mat2(dot(n1, j[b]), dot(n2, j[b]),
+                    dot(n1, j[c]), dot(n2, j[c]));
+    vec2 duv = inverse(jf) * dist;
+
+    r_p[b] = clamp(r_p[b] - duv.x, -0.5, 1.5);
+    r_p[c] = clamp(r_p[c] - duv.y, -0.5, 1.5);
+  }
+
+  return false;
+}
+
+bool intersect_elem(const in vec3 ro, const in vec3 rd, const in int face_num,
+                    out vec3 r_p, out float t)
+{
+  const uint  max_steps = 8;
+  const float hit_tol   = 1e-3;
+        float res_tol   = 1e-4 * ubo.tol_scale;  // relative to the face size
+
+  r_p = vec3(0.);
+  t   = 0.;
+
+  // faces are hollow, a clipped face is simply not hit where it is cut away
+
+  aabb box            = face_bboxes[face_num];
+  vec2 bbox_intersect = clipped_aabb_intersect(ro, rd, box);
+  if (bbox_intersect.x == -1. && bbox_intersect.y == -1.)
+  {
+    return false;
+  }
+
+  int   elem_num = faces[face_num] / 6;
+  int   face     = faces[face_num] % 6;
+  int   a        = face / 2;  // fixed reference axis
+  int   b        = (a + 1) % 3;
+  int   c        = (a + 2) % 3;
+  float side     = float(face % 2);
+
+  // affine faces are planes in reference space
+
+  if (elem_affine(elem_num))
+  {
+    vec3 ro_ref, rd_ref;
+    affine_ray2ref(ro, rd, elem_num, ro_ref, rd_ref);
+
+    if (abs(rd_ref[a]) < FLT_EPSILON)
+    {
+      return false;
+    }
+
+    t      = (side - ro_ref[a]) / rd_ref[a];
+    r_p    = ro_ref + t * rd_ref;
+    r_p[a] = side;
+
+    return t > 0. && clip_visible(ro + t * rd) &&
+           r_p[b] > 0. - hit_tol && r_p[b] < 1. + hit_tol &&
+           r_p[c] > 0. - hit_tol && r_p[c] < 1. + hit_tol;
+  }
+
+  r_p    = warm_start(ro + bbox_intersect.x * rd, elem_num);
+  r_p[a] = side;
+
+  float tol2 = res_tol * res_tol * dot(box.h - box.l, box.h - box.l);
+  vec3  g_p;
+  if (!face_newton(ro, rd, elem_num, face, max_steps, tol2, r_p, g_p))
+  {
+    return false;
+  }
+
+  t = dot(g_p - ro, rd) / dot(rd, rd);
+
+  return t > 0. && clip_visible(ro + t * rd) &&
+         r_p[b] > 0. - hit_tol && r_p[b] < 1. + hit_tol &&
+         r_p[c] > 0. - hit_tol && r_p[c] < 1. + hit_tol;
+}
+
+// Temporal reuse entry point. A face solve is already short, so an earlier
+// hit on the same face gains little and the face is simply solved again.
+bool intersect_elem_warm(const in vec3 ro, const in vec3 rd,
+                         const in int face_num, const in vec3 ref_guess,
+                         const in float t_guess, out vec3 r_p, out float t)
+{
+  return intersect_elem(ro, rd, face_num, r_p, t);
+}
+
+#include "kd_traversal.glsl"
+
+
+vec4 shade_hit(const in vec3 ro, const in vec3 rd, const in int face_num,
+               const in vec3 hit_pos, const in float thit)
+{
+  float min = domain_otlim.x;
+  float max = domain_otlim.y;
+
+  float state[5];
+  interp_state(clamp(hit_pos, vec3(0.), vec3(1.)), face_elem(face_num), state);
+
+  return map_color(SPEC_OUTPUT, min, max, state, params.gamma);
+}
+
+vec4 raycast(const in vec3 ro, const in vec3 rd)
+{
+  int elem_num; bool hit_geom; vec3 hit_pos; float thit;
+  kd_ray_traverse(ro, rd, elem_num, hit_geom, hit_pos, thit);
+
+  if (hit_geom)
+  {
+    return shade_hit(ro, rd, elem_num, hit_pos, thit);
+  }
+  else
+  {
+    return clear_color;
+  }
+}
+
+
+#endif
@@ -0,0 +1,54 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_COMPUTE
+#define SHDR_RAYCAST_COMPUTE
+
+
+// Tiled compute entry point shared by the raycast_*_tiled.comp shaders. The
+// includer provides "raycast(ro, rd)" through one of the raycast_<mode>.glsl
+// files. Every pixel of the tile traces its own ray independently.
+
+
+#include "raycast_tile.glsl"
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  if (pixel.x >= uint(size.x) || pixel.y >= uint(size.y))
+    return;
+
+  if (tile_culled)
+  {
+    imageStore(render_target, ivec2(pixel), clear_color);
+    return;
+  }
+
+  vec3 ro, rd;
+  find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview, tile_iproj,
+                   ro, rd);
+
+  imageStore(render_target, ivec2(pixel), raycast(ro, rd));
+}
+
+
+#endif
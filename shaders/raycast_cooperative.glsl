@@ -0,0 +1,204 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_COOPERATIVE
+#define SHDR_RAYCAST_COOPERATIVE
+
+
+// Tile cooperative compute entry point shared by the
+// raycast_*_cooperative.comp shaders. The includer provides "intersect_elem"
+// and "shade_hit" through one of the raycast_<mode>.glsl files, included after
+// coefficient_cache.glsl so both read the shared element cache.
+//
+// Rays of a tile step through the kd tree independently but evaluate elements
+// in lockstep rounds. Each round every ray offers the element it needs next
+// (the next leaf element while tracing, its closest hit once done tracing),
+// the smallest offered element is elected and loaded into shared memory once,
+// and all rays that offered it evaluate it from there. Neighboring rays
+// mostly need the same few elements, so those are fetched from the node and
+// state buffers once per tile rather than once per ray.
+
+
+#include "constants.glsl"
+#include "raycast_tile.glsl"
+#include "clipping.glsl"
+
+
+const int phase_done  = 0;
+const int phase_trace = 1;
+const int phase_shade = 2;
+
+shared int elected;
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  // invocations outside the image stay along for the barriers below
+
+  bool inside = pixel.x < uint(size.x) && pixel.y < uint(size.y);
+  vec4 color  = clear_color;
+  int  phase  = phase_done;
+
+  vec3  ro = vec3(0.), rd = vec3(0.);
+  float tmin = 0., tmax = 0., domain_tmax = 0.;
+  int   node_num = 0;
+  bool  in_leaf  = false;
+  uint  cursor   = 0;
+
+  vec3  hit_pos   = vec3(0.);
+  float hit_t     = FLT_MAX;
+  int   hit_elem  = -1;
+
+  const int missed_cache_size         = 8;
+  int missed_cache[missed_cache_size] = int[](-1, -1, -1, -1, -1, -1, -1, -1);
+  int missed_cache_head               = 0;
+
+  if (inside && !tile_culled)
+  {
+    find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview,
+                     tile_iproj, ro, rd);
+
+    vec2 domain_intersect = clipped_aabb_intersect(ro, rd, domain_bbox);
+    if (!(domain_intersect.x == -1. && domain_intersect.y == -1.))
+    {
+      tmin        = domain_intersect.x;
+      tmax        = domain_intersect.y;
+      domain_tmax = domain_intersect.y;
+      phase       = phase_trace;
+    }
+  }
+
+  // Every round the rays offering the elected element step past it (or finish
+  // shading), so the rounds end once each ray's traversal does. There is no
+  // round cap, one would leave rays unfinished.
+
+  while (true)
+  {
+    // advance this ray to the next element it needs
+
+    int candidate = -1;
+    while (phase == phase_trace)
+    {
+      if (!in_leaf)
+      {
+        if (!kd_next_leaf(ro, rd, node_num, tmin, tmax))
+        {
+          phase = hit_elem >= 0 ? phase_shade : phase_done;
+          break;
+        }
+        in_leaf = true;
+        cursor  = 0;
+      }
+
+      kdnode leaf = kdnodes[node_num];
+      if (cursor < leaf.count)
+      {
+        int test_elem = kdleafelems[leaf.offset + cursor];
+
+        bool already_missed = false;
+        for (uint ci = 0; ci < missed_cache_size; ++ci)
+        {
+          if (missed_cache[ci] == test_elem) { already_missed = true; break; }
+        }
+        if (already_missed) { ++cursor; continue; }
+
+        candidate = test_elem;
+        break;
+      }
+
+      // leaf exhausted, stop at the first leaf with a hit
+
+      in_leaf = false;
+      if (hit_elem >= 0 ||
+          !kd_leave_leaf(ro, rd, domain_tmax, node_num, tmin, tmax))
+      {
+        phase = hit_elem >= 0 ? phase_shade : phase_done;
+      }
+    }
+
+    if (phase == phase_shade)
+    {
+      candidate = hit_elem;
+    }
+
+    // elect one element for the whole tile
+
+    if (gl_LocalInvocationIndex == 0)
+    {
+      elected = INT_MAX;
+    }
+    barrier();
+
+    if (candidate >= 0)
+    {
+      atomicMin(elected, candidate);
+    }
+    barrier();
+
+    int elem_num = elected;
+    if (elem_num == INT_MAX)  // uniform, every ray is done
+    {
+      break;
+    }
+
+    cache_element(elem_num);
+    barrier();
+
+    if (candidate == elem_num)
+    {
+      if (phase == phase_trace)
+      {
+        vec3 r_p; float thit = FLT_MAX;
+        bool hit = intersect_elem(ro, rd, elem_num, r_p, thit);
+
+        if (hit && thit < hit_t)
+        {
+          hit_t    = thit;
+          hit_pos  = r_p;
+          hit_elem = elem_num;
+        }
+        else if (!hit)
+        {
+          missed_cache[missed_cache_head] = elem_num;
+          missed_cache_head = ((missed_cache_head + 1) % missed_cache_size);
+        }
+
+        ++cursor;
+      }
+      else
+      {
+        color = shade_hit(ro, rd, elem_num, hit_pos, hit_t);
+        phase = phase_done;
+      }
+    }
+
+    barrier();  // everyone is done with the cache before it is reloaded
+  }
+
+  if (inside)
+  {
+    imageStore(render_target, ivec2(pixel), color);
+  }
+}
+
+
+#endif
@@ -0,0 +1,79 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_DEFERRED
+#define SHDR_RAYCAST_DEFERRED
+
+
+// Deferred compute entry points shared by the raycast_*_deferred_trace.comp
+// and raycast_*_deferred_shade.comp shaders. The includer provides the k-d
+// traversal and "shade_hit" through one of the raycast_<mode>.glsl files and
+// defines DEFERRED_TRACE or DEFERRED_SHADE to pick the pass. Both passes use
+// the tiles of the tiled path.
+
+
+#include "raycast_tile.glsl"
+#include "visibility.glsl"
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  if (pixel.x >= uint(size.x) || pixel.y >= uint(size.y))
+    return;
+
+  uint pixel_num = pixel.y * uint(size.x) + pixel.x;
+
+  vec3 ro, rd;
+  find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview, tile_iproj,
+                   ro, rd);
+
+#if defined(DEFERRED_TRACE)
+
+  int elem_num = -1; bool hit_geom = false; vec3 hit_pos = vec3(0.);
+  float thit = 0.;
+
+  if (!tile_culled)
+  {
+    kd_ray_traverse(ro, rd, elem_num, hit_geom, hit_pos, thit);
+  }
+
+  vis_hit[pixel_num]  = vec4(hit_pos, thit);
+  vis_elem[pixel_num] = hit_geom ? elem_num : -1;
+
+#elif defined(DEFERRED_SHADE)
+
+  int  elem_num = vis_elem[pixel_num];
+  vec4 hit      = vis_hit[pixel_num];
+
+  vec4 color = clear_color;
+  if (elem_num >= 0)
+  {
+    color = shade_hit(ro, rd, elem_num, hit.xyz, hit.w);
+  }
+
+  imageStore(render_target, ivec2(pixel), color);
+
+#endif
+}
+
+
+#endif
@@ -27,8 +27,46 @@ layout(set = 0, binding = 0) uniform uniform_buffer_object {
   mat4 proj;
 
   mat4 slice_model;
+
+  uint  surface_rounds;  // intersection budgets set by the frame governor
+  uint  iso_rounds;
+  uint  slice_steps;
+  float tol_scale;
+
+  vec4 isovalues[2];  // isosurface mode contours, niso of them
+  uint niso;
+
+  uint nslices;            // slice set mode planes (normal, offset)
+  vec4 slice_planes[20];
+
+  uint nclip_planes;       // clip region half spaces (normal, offset)
+  uint clip_box_on;
+  vec4 clip_planes[4];
+  vec4 clip_box_l;
+  vec4 clip_box_h;
 } ubo;
 
+
+// contour k of the isosurface mode's ubo.niso isovalues
+float isovalue(const in uint k)
+{
+  return ubo.isovalues[k / 4][k % 4];
+}
+
+// contours inside an output range, bit k set for contour k
+uint iso_mask(const in vec2 bounds)
+{
+  uint mask = 0;
+  for (uint k = 0; k < min(ubo.niso, 8u); ++k)
+  {
+    float iso = isovalue(k);
+    if (iso >= bounds.x && iso <= bounds.y)
+      mask |= 1u << k;
+  }
+  return mask;
+}
+
+
 layout(std430, set = 2, binding = 0) buffer solver_params {
   uint p;
   uint q;
@@ -47,12 +85,23 @@ layout(std430, set = 2, binding = 5) buffer dombbox_data { aabb domain_bbox;  };
 layout(std430, set = 2, binding = 6) buffer domot_data   { vec2 domain_otlim; };
 layout(std430, set = 2, binding = 7) buffer kdnode_data  { kdnode kdnodes[];  };
 layout(std430, set = 2, binding = 8) buffer kdleaf_data  { int kdleafelems[]; };
-layout(std430, set = 2, binding = 9) buffer cmap_data    { float cmap[];      };
+layout(set = 2, binding = 9) uniform sampler2D cmap_texture;  // 256 x 1
 layout(std430, set = 2, binding = 10) buffer output_data { int output_option; };
-
-layout(location = 0) in vec4 ndc_pos;
-
-layout(location = 0) out vec4 out_color;
+layout(std430, set = 2, binding = 11) buffer emap_data {
+  elem_inverse_map elem_maps[];
+};
+layout(std430, set = 2, binding = 12) buffer ewarm_data { vec4 elem_warm[]; };
+layout(std430, set = 2, binding = 13) buffer face_data  { int faces[]; };
+layout(std430, set = 2, binding = 14) buffer fbbox_data { aabb face_bboxes[]; };
+layout(std430, set = 2, binding = 15) buffer fkdnode_data {
+  kdnode face_kdnodes[];
+};
+layout(std430, set = 2, binding = 16) buffer fkdleaf_data {
+  int face_kdleaffaces[];
+};
+layout(std430, set = 2, binding = 17) buffer subcell_data {
+  vec2 subcell_bounds[];
+};
 
 
 const vec4 clear_color = vec4(0., 0., 0., 1.);
@@ -0,0 +1,48 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#version 450
+
+#include "raycast_isosurface.glsl"
+
+
+// The mesh path draws the isosurface as the triangle mesh extracted by
+// iso_mesh_emit.comp, shaded like a raycast hit at the interpolated position
+// and reference coordinates.
+
+
+layout(location = 0) in vec3 frag_pos;
+layout(location = 1) in vec3 frag_ref;
+layout(location = 2) flat in vec3 frag_ro;
+layout(location = 3) flat in int frag_elem;
+layout(location = 4) flat in int frag_face;  // contour for mesh vertices
+
+layout(location = 0) out vec4 out_color;
+
+
+void main()
+{
+  if (!clip_visible(frag_pos))
+  {
+    discard;
+  }
+
+  vec3 r_p = clamp(frag_ref, vec3(0.), vec3(1.));
+
+  out_color = shade_hit(frag_pos, normalize(frag_pos - frag_ro), frag_elem,
+                        r_p, 0.);
+}
@@ -0,0 +1,598 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_ISOSURFACE
+#define SHDR_RAYCAST_ISOSURFACE
+
+
+#include "raycast_interface_layout.glsl"
+
+#include "intersections.glsl"
+#include "clipping.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+#include "subcell_bounds.glsl"
+#include "bernstein.glsl"
+#include "colormapping.glsl"
+
+
+// void obj_dist(const in vec3 ro, const in vec3 rd,
+//               const in vec3 p, const in mat3 j,
+//               out float dist, out vec3 dist_ref)
+// {
+//   vec3  d         = (p - ro) - (dot(p - ro, rd) * rd);
+//         dist      = length(d);
+//   float idist     = 1. / dist;
+//
+//   mat3  d_p       = mat3(1.) - outerProduct(rd, rd);
+//   vec3  dist_glob = (d_p * d) * idist;
+//
+//         dist_ref  = dist_glob * j;
+// }
+//
+//
+// void obj_xmom(const in float s[5],
+//               const in float sx[5], const in float sy[5], const in float sz[5],
+//               out float obj, out vec3 obj_ref)
+// {
+//   const float inorm = 1. / (0.1 * 0.1);
+//
+//   float err    = s[1] - 0.075;
+//         obj    = (err * err) * inorm;
+//
+//   vec3 o_ref   = vec3(sx[1], sy[1], sz[1]);
+//        obj_ref = 2. * inorm * err * o_ref;
+// }
+//
+//
+// void obj(const in vec3 ro, const in vec3 rd,
+//          const in vec3 ref, const in int elem_num,
+//          out float f, out vec3 f_ref, out vec3 glo)
+// {
+//   mat3 j;
+//   mapinfo(ref, elem_num, glo, j);
+//
+//   float s[5]; float sx[5]; float sy[5]; float sz[5];
+//   interp_state_grad(ref, elem_num, s, sx, sy, sz);
+//
+//   float dist; vec3 dist_ref;
+//   obj_dist(ro, rd, glo, j, dist, dist_ref);
+//
+//   float oerr; vec3 oerr_ref;
+//   obj_xmom(s, sx, sy, sz, oerr, oerr_ref);
+//
+//   f     = oerr + dist;
+//   f_ref = dist_ref + oerr_ref;
+// }
+//
+//
+// vec4 test_out = vec4(0., 0., 0., 1.);
+//
+//
+// float pinpoint(in float al, in float ah,
+//                in float fl, in float fh,
+//                in float f_pl, in float f_ph,
+//                const in vec3 ro, const in vec3 rd, const in int elem_num,
+//                const in vec3 ref0, in vec3 p,
+//                const in float f0, const in float f_p0,
+//                const in float mu1, const in float mu2)
+// {
+//   for (uint i = 0; i < 6; ++i)
+//   {
+//     // float ap = 0.5 * (al + ah);
+//     float ap = (2. * al * (fh - fl) + f_pl * (al * al - ah * ah)) /
+//                (2. * (fh - fl + f_pl * (al - ah)));
+//
+//     float fp; vec3 f_refp; vec3 _;
+//     vec3 refp = ref0 + p * ap;
+//     obj(ro, rd, refp, elem_num, fp, f_refp, _);
+//     float f_pp = dot(p, f_refp);
+//
+//     if ((fp > f0 + mu1 * ap * f_p0) || (fp > fl))
+//     {
+//       ah   = ap;
+//       fh   = fp;
+//       f_ph = f_pp;
+//
+//       // test_out.x += 0.1;
+//     }
+//     else
+//     {
+//       if (abs(f_pp) <= mu2 * -f_p0)
+//       {
+//         return ap;
+//       }
+//       else if (f_pp * (ah - al) >= 0.)
+//       {
+//         ah   = al;
+//         fh   = fl;
+//         f_ph = f_pl;
+//       }
+//       al   = ap;
+//       fl   = fp;
+//       f_pl = f_pp;
+//
+//       // test_out.y += 0.1;
+//     }
+//   }
+//
+//   return -1.;
+// }
+//
+//
+// float line_search(const in vec3 ro, const in vec3 rd, const in int elem_num,
+//                   const in vec3 ref0, in vec3 p,
+//                   const in float f0, const in float f_p0,
+//                   const in float mu1, const in float mu2)
+// {
+//         p    = normalize(p);
+//   float a1   = 0.;
+//   float a2   = 0.5;
+//   float f1   = f0;
+//   float f_p1 = f_p0;
+//
+//   for (uint i = 0; i < 2; ++i)
+//   {
+//     float f2; vec3 f_ref2; vec3 _;
+//
+//     vec3 ref2 = ref0 + p * a2;
+//     obj(ro, rd, ref2, elem_num, f2, f_ref2, _);
+//     float f_p2 = dot(p, f_ref2);
+//
+//     if ((f2 > f0 + mu1 * a2 * f_p0) || (i > 0 && f2 > f1))  // call pinpoint
+//     {
+//       return pinpoint(a1, a2, f1, f2, f_p1, f_p2,
+//                       ro, rd, elem_num, ref0, p, f0, f_p0, mu1, mu2);
+//     }
+//
+//     if (abs(f_p2) <= mu2 * -f_p0)
+//     {
+//       return a2;
+//     }
+//     else if (f_p2 >= 0.)
+//     {
+//       return pinpoint(a2, a1, f2, f1, f_p2, f_p1,
+//                       ro, rd, elem_num, ref0, p, f0, f_p0, mu1, mu2);
+//     }
+//     else
+//     {
+//       a1   = a2;
+//       f1   = f2;
+//       f_p1 = f_p2;
+//       a2  *= 2.;
+//     }
+//   }
+//
+//   return -2.;
+// }
+
+
+bool intersect_once(const in vec3 ro, const in vec3 rd,
+                    const in float isoval, const in int elem_num,
+                    const in bool affine, inout vec3 ref, inout float t)
+{
+        uint max_rounds = ubo.iso_rounds;
+        uint max_steps  = 3;  // starting value, drops to "step_drop" later
+  const uint step_drop  = 2;
+  const float damp      = 1.;
+        float hit_tol   = 1e-3 * ubo.tol_scale;
+
+  aabb refbox;
+  refbox.l = vec3(0.);
+  refbox.h = vec3(1.);
+
+  bool hit = false;
+  for (uint round = 0; round < max_rounds; ++round)
+  {
+    mat3 j, ij;
+    vec3 glo, glo_target = ro + t * rd;
+    if (affine)
+    {
+      ij  = elem_inverse_jacobian(elem_num);
+      ref = affine_glo2ref(glo_target, elem_num);
+    }
+    else
+    {
+      for (uint step = 0; step < max_steps; ++step)
+      {
+        mapinfo(ref, elem_num, glo, j);
+        ij   = inverse(j);
+        ref -= ij * (glo - glo_target);
+      }
+    }
+
+    float s[5]; float s_x[5]; float s_y[5]; float s_z[5];
+    interp_state_grad(ref, elem_num, s, s_x, s_y, s_z);
+
+    float o = eval_output(SPEC_OUTPUT, s, params.gamma);
+
+    if (inside_aabb(ref, refbox) && (abs(o - isoval) < hit_tol))
+    {
+      hit = true;
+      break;
+    }
+
+    float o_s[5];
+    eval_output_grad(SPEC_OUTPUT, s, params.gamma, o_s);
+
+    vec3 o_xi = vec3(
+    o_s[0] * s_x[0] + o_s[1] * s_x[1] + o_s[2] * s_x[2] + o_s[3] * s_x[3] + o_s[4] * s_x[4],
+    o_s[0] * s_y[0] + o_s[1] * s_y[1] + o_s[2] * s_y[2] + o_s[3] * s_y[3] + o_s[4] * s_y[4],
+    o_s[0] * s_z[0] + o_s[1] * s_z[1] + o_s[2] * s_z[2] + o_s[3] * s_z[3] + o_s[4] * s_z[4]);
+
+    float o_t = dot(o_xi * ij, rd);
+    t        -= damp * ((o - isoval) / o_t);
+
+    max_steps = step_drop;
+  }
+
+  return hit;
+}
+
+
+// Affine elements map rays to straight reference space segments, so along
+// one the isosurface residual numer - isoval * denom (see output_ratio), or
+// numer - isoval for a single component, is a polynomial of degree 3p. It is
+// built exactly from the element coefficients in Bernstein form and its first
+// root in [t_min, t_max] isolated from coefficient signs.
+bool intersect_affine_exact(const in vec3 ro_ref, const in vec3 rd_ref,
+                            const in int elem_num, const in float isoval,
+                            const in uint numer, const in int denom,
+                            const in float t_min, const in float t_max,
+                            out vec3 ref, out float t)
+{
+  const float s_tol = 1e-4;  // relative to the segment length
+
+  ref = vec3(0.);
+  t   = 0.;
+
+  aabb refbox;
+  refbox.l = vec3(0.);
+  refbox.h = vec3(1.);
+
+  vec2 span = aabb_intersect(ro_ref, rd_ref, refbox);
+  if (span.x == -1. && span.y == -1.)
+  {
+    return false;
+  }
+  span.x = max(span.x, t_min);
+  span.y = min(span.y, t_max);
+  if (span.x >= span.y)
+  {
+    return false;
+  }
+
+  vec3 r0 = ro_ref + span.x * rd_ref;
+  vec3 r1 = ro_ref + span.y * rd_ref;
+
+  float bx[mop1][mop1], by[mop1][mop1], bz[mop1][mop1];
+  for (uint i = 0; i < SPEC_PP1; ++i)
+  {
+    basis_segment_bernstein(i, r0.x, r1.x, bx[i]);
+    basis_segment_bernstein(i, r0.y, r1.y, by[i]);
+    basis_segment_bernstein(i, r0.z, r1.z, bz[i]);
+  }
+
+  // tensor product contraction, products of scaled coefficients convolve
+
+  float f[bern_size];
+  for (uint k = 0; k < bern_size; ++k)
+    f[k] = 0.;
+
+  for (uint iz = 0; iz < SPEC_PP1; ++iz)
+  {
+    float fy[bern_size];
+    for (uint k = 0; k < bern_size; ++k)
+      fy[k] = 0.;
+
+    for (uint iy = 0; iy < SPEC_PP1; ++iy)
+    {
+      uint i = SPEC_PP1 * (SPEC_PP1 * iz + iy);
+
+      float fx[mop1];
+      for (uint k = 0; k < mop1; ++k)
+        fx[k] = 0.;
+
+      for (uint ix = 0; ix < SPEC_PP1; ++ix)
+      {
+        // a single component subtracts the isovalue as a constant, the
+        // Lagrange basis sums to one, the monomial one has it in x^0 y^0 z^0
+
+        float c = MAPPING_STATE(elem_num, numer, i + ix);
+        if (denom >= 0)
+          c -= isoval * MAPPING_STATE(elem_num, uint(denom), i + ix);
+        else if (!SPEC_MONOMIAL || i + ix == 0)
+          c -= isoval;
+
+        for (uint k = 0; k < SPEC_PP1; ++k)
+          fx[k] += c * bx[ix][k];
+      }
+
+      for (uint k = 0; k < SPEC_PP1; ++k)
+        for (uint l = 0; l < SPEC_PP1; ++l)
+          fy[k + l] += fx[k] * by[iy][l];
+    }
+
+    for (uint k = 0; k <= 2 * SPEC_P; ++k)
+      for (uint l = 0; l < SPEC_PP1; ++l)
+        f[k + l] += fy[k] * bz[iz][l];
+  }
+
+  uint n = 3 * SPEC_P;
+  bernstein_unscale(n, f);
+
+  float s = bernstein_first_root(n, f, s_tol);
+  if (s < 0.)
+  {
+    return false;
+  }
+
+  t   = mix(span.x, span.y, s);
+  ref = clamp(ro_ref + t * rd_ref, vec3(0.), vec3(1.));
+
+  return true;
+}
+
+// Ray interval through a subcell box, (FLT_MAX, FLT_MAX) when the ray misses
+// it. Curved elements follow the linearized reference ray to within "pad"
+// (see elem_ref_pad), their boxes are widened by it.
+vec2 subcell_interval(const in vec3 ro_ref, const in vec3 rd_ref, in aabb box,
+                      const in vec3 pad)
+{
+  box.l -= pad;
+  box.h += pad;
+
+  vec2 interval = aabb_intersect(ro_ref, rd_ref, box);
+  if (interval.x == -1. && interval.y == -1.)
+  {
+    return vec2(FLT_MAX);
+  }
+
+  return interval;
+}
+
+// contours inside the element's octant ranges, unlike the sampled element
+// range in otp_bounds these bound the output strictly
+uint elem_iso_mask(const in int elem_num)
+{
+  uint mask = 0;
+  for (uint o = 0; o < 8; ++o)
+    mask |= iso_mask(octant_bounds(elem_num, o));
+  return mask;
+}
+
+// removes and returns the interval with the nearest entry (8 when all are
+// gone)
+uint pop_nearest(inout vec2 intervals[8], out vec2 nearest)
+{
+  uint inear = 8;
+  nearest    = vec2(FLT_MAX);
+  for (uint i = 0; i < 8; ++i)
+  {
+    if (intervals[i].x < nearest.x)
+    {
+      inear   = i;
+      nearest = intervals[i];
+    }
+  }
+
+  if (inear < 8)
+  {
+    intervals[inear] = vec2(FLT_MAX);
+  }
+
+  return inear;
+}
+
+// All contours share one pass over the element: the output range tests are
+// done once per subcell for every contour (as isovalue masks) and the nearest
+// hit over all contours is kept.
+//
+// The element's octants and then their leaf subcells are visited front to
+// back along the ray, skipping any the ray misses or whose output range
+// excludes every contour. Newton is seeded in the middle of each remaining
+// leaf's ray interval for each contour in its range, the descent stops once
+// the next candidate starts behind the nearest hit. Affine elements take the
+// exact polynomial path instead when the output allows it.
+bool intersect_elem(const in vec3 ro, const in vec3 rd, const in int elem_num,
+                    out vec3 ref, out float t)
+{
+  ref = vec3(0.);
+  t   = FLT_MAX;
+
+  // output limit check
+  uint elem_mask = elem_iso_mask(elem_num);
+  if (elem_mask == 0)
+  {
+    return false;
+  }
+
+  // bounding box check, hits are kept to the box's part of the clip region
+  vec2 bbox_intersect = clipped_aabb_intersect(ro, rd, bboxes[elem_num]);
+  if (bbox_intersect.x == -1. && bbox_intersect.y == -1.)
+  {
+    return false;
+  }
+
+  // the center linearization of the mapping is exact for affine elements
+
+  bool affine = elem_affine(elem_num);
+  vec3 pad    = elem_ref_pad(elem_num);
+
+  vec3 ro_ref, rd_ref;
+  affine_ray2ref(ro, rd, elem_num, ro_ref, rd_ref);
+
+  bool hit = false;
+
+  uint numer; int denom;
+  if (affine && output_ratio(SPEC_OUTPUT, numer, denom))
+  {
+    for (uint k = 0; k < 8; ++k)
+    {
+      vec3 try_ref; float try_t;
+      if ((elem_mask & (1u << k)) != 0 &&
+          intersect_affine_exact(ro_ref, rd_ref, elem_num, isovalue(k), numer,
+                                 denom, max(bbox_intersect.x, 0.),
+                                 min(t, bbox_intersect.y), try_ref, try_t))
+      {
+        hit = true;
+        ref = try_ref;
+        t   = try_t;
+      }
+    }
+
+    return hit;
+  }
+
+  vec2 octants[8];
+  uint octant_masks[8];
+  for (uint o = 0; o < 8; ++o)
+  {
+    octant_masks[o] = elem_mask & iso_mask(octant_bounds(elem_num, o));
+    octants[o]      = octant_masks[o] == 0 ? vec2(FLT_MAX) :
+                      subcell_interval(ro_ref, rd_ref, octant_box(o), pad);
+  }
+
+  vec2 octant_span;
+  for (uint o = pop_nearest(octants, octant_span);
+       o < 8 && octant_span.x < t; o = pop_nearest(octants, octant_span))
+  {
+    vec2 leaves[8];
+    uint leaf_masks[8];
+    for (uint c = 0; c < 8; ++c)
+    {
+      leaf_masks[c] = octant_masks[o] & iso_mask(leaf_bounds(elem_num, o, c));
+      leaves[c]     = leaf_masks[c] == 0 ? vec2(FLT_MAX) :
+                      subcell_interval(ro_ref, rd_ref, leaf_box(o, c), pad);
+    }
+
+    vec2 leaf_span;
+    for (uint c = pop_nearest(leaves, leaf_span);
+         c < 8 && leaf_span.x < t; c = pop_nearest(leaves, leaf_span))
+    {
+      for (uint k = 0; k < 8; ++k)
+      {
+        if ((leaf_masks[c] & (1u << k)) == 0)
+          continue;
+
+        float try_t   = 0.5 * (leaf_span.x + leaf_span.y);
+        vec3  try_ref = clamp(ro_ref + try_t * rd_ref, vec3(0.), vec3(1.));
+        bool  try_hit = intersect_once(ro, rd, isovalue(k), elem_num, affine,
+                                       try_ref, try_t);
+
+        if (try_hit && try_t < t && try_t >= bbox_intersect.x &&
+            try_t <= bbox_intersect.y)
+        {
+          hit = true;
+          ref = try_ref;
+          t   = try_t;
+        }
+      }
+    }
+  }
+
+  return hit;
+}
+
+
+// Intersection seeded by an earlier hit on the same element (temporal reuse),
+// a single Newton solve per contour from the earlier reference point and ray
+// parameter. Callers fall back to a full traversal on failure.
+bool intersect_elem_warm(const in vec3 ro, const in vec3 rd,
+                         const in int elem_num, const in vec3 ref_guess,
+                         const in float t_guess, out vec3 ref, out float t)
+{
+  uint elem_mask = elem_iso_mask(elem_num);
+  bool affine    = elem_affine(elem_num);
+
+  ref = ref_guess;
+  t   = t_guess;
+
+  // the nearest of the contours solved from the earlier hit
+
+  bool hit = false;
+  for (uint k = 0; k < 8; ++k)
+  {
+    if ((elem_mask & (1u << k)) == 0)
+      continue;
+
+    vec3  try_ref = ref_guess;
+    float try_t   = t_guess;
+    if (intersect_once(ro, rd, isovalue(k), elem_num, affine, try_ref, try_t) &&
+        (!hit || try_t < t) && clip_visible(ro + try_t * rd))
+    {
+      hit = true;
+      ref = try_ref;
+      t   = try_t;
+    }
+  }
+
+  return hit;
+}
+
+#include "kd_traversal.glsl"
+
+vec4 shade_hit(const in vec3 ro, const in vec3 rd, const in int elem_num,
+               const in vec3 hit_pos, const in float thit)
+{
+  vec3 glo_hit = ro + thit * rd;
+
+  float dom_height = domain_bbox.h.y - domain_bbox.l.y;
+
+  float intensity = (0.5 * dom_height - abs(glo_hit.y)) / (0.5 * dom_height);
+  if (ubo.niso < 2)
+  {
+    return vec4(intensity, intensity, intensity, 1.);
+  }
+
+  // several contours are told apart by the colormap at their isovalue
+
+  float state[5];
+  interp_state(hit_pos, elem_num, state);
+  float val = eval_output(SPEC_OUTPUT, state, params.gamma);
+
+  float iso = isovalue(0);
+  for (uint k = 1; k < min(ubo.niso, 8u); ++k)
+  {
+    if (abs(isovalue(k) - val) < abs(iso - val))
+      iso = isovalue(k);
+  }
+
+  float min = domain_otlim.x;
+  float max = domain_otlim.y;
+
+  return vec4(intensity * sample_colormap((iso - min) / (max - min)), 1.);
+}
+
+vec4 raycast(const in vec3 ro, const in vec3 rd)
+{
+  int elem_num; bool hit_geom; vec3 hit_pos; float thit;
+  kd_ray_traverse(ro, rd, elem_num, hit_geom, hit_pos, thit);
+
+  /* set color if intersection successful */
+
+  if (hit_geom)
+  {
+    return shade_hit(ro, rd, elem_num, hit_pos, thit);
+  }
+  else
+  {
+    return clear_color;
+  }
+}
+
+
+#endif
@@ -0,0 +1,77 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_PACKET
+#define SHDR_RAYCAST_PACKET
+
+
+// Packet compute entry point shared by the raycast_*_packet.comp shaders. The
+// includer provides "intersect_elem", "shade_hit" and "raycast" through one of
+// the raycast_<mode>.glsl files. Morton ordered tiles make each subgroup a
+// compact block of primary rays which traverse the k-d tree as one packet
+// (see kd_packet.glsl). Packets whose ray directions straddle an axis fall
+// back to independent traversal.
+
+
+#include "raycast_tile.glsl"
+#include "kd_packet.glsl"
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  // invocations outside the image stay along for the subgroup operations
+
+  bool inside = pixel.x < uint(size.x) && pixel.y < uint(size.y);
+  bool active = inside && !tile_culled;
+
+  vec3 ro = vec3(0.), rd = vec3(1.);
+  if (active)
+  {
+    find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview,
+                     tile_iproj, ro, rd);
+  }
+
+  vec4 color = clear_color;
+
+  if (packet_coherent(rd, active))
+  {
+    int elem_num; bool hit_geom; vec3 hit_pos; float thit;
+    kd_packet_traverse(ro, rd, active, elem_num, hit_geom, hit_pos, thit);
+
+    if (hit_geom)
+    {
+      color = shade_hit(ro, rd, elem_num, hit_pos, thit);
+    }
+  }
+  else if (active)
+  {
+    color = raycast(ro, rd);
+  }
+
+  if (inside)
+  {
+    imageStore(render_target, ivec2(pixel), color);
+  }
+}
+
+
+#endif
@@ -0,0 +1,116 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_PROGRESSIVE
+#define SHDR_RAYCAST_PROGRESSIVE
+
+
+// Progressive tiled entry point shared by the raycast_*_progressive.comp
+// shaders (see progressive.glsl). Blocks never cross an 8x8 screen tile, so
+// the nearest traced sample of a pixel's block is found in shared memory.
+
+
+#include "constants.glsl"
+#include "raycast_tile.glsl"
+#include "progressive.glsl"
+
+
+shared vec4 tile_samples[tile_size * tile_size];
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 local = morton_decode(gl_LocalInvocationIndex);
+  uvec2 pixel = tile * tile_size + local;
+
+  bool inside = pixel.x < uint(size.x) && pixel.y < uint(size.y);
+  uint pindx  = pixel.y * uint(size.x) + pixel.x;
+
+  uint block   = 1u << pc.block_log2;
+  uint nsample = block * block;
+
+  tile_begin(tile, size);
+
+  // trace this frame's pixel of each block, invalidate the rest on a reset
+
+  vec4 own = vec4(0.);
+  if (inside)
+  {
+    bool traced = pc.step < nsample &&
+                  (local & (block - 1u)) ==
+                  progressive_offset(pc.step, pc.block_log2);
+
+    if (traced)
+    {
+      vec4 color = clear_color;
+      if (!tile_culled)
+      {
+        vec3 ro, rd;
+        find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview,
+                         tile_iproj, ro, rd);
+        color = raycast(ro, rd);
+      }
+
+      own          = vec4(color.rgb, 1.);
+      accum[pindx] = own;
+    }
+    else if (pc.step == 0)
+    {
+      accum[pindx] = own;
+    }
+    else
+    {
+      own = accum[pindx];
+    }
+  }
+
+  tile_samples[local.y * tile_size + local.x] = own;
+  barrier();
+
+  if (!inside)
+    return;
+
+  // untraced pixels take the nearest traced sample of their block, the first
+  // step traces each block's corner so one always exists
+
+  vec4 color = own;
+  if (color.a == 0.)
+  {
+    uvec2 base = local & ~(block - 1u);
+    float best = FLT_MAX;
+    for (uint j = 0; j < block; ++j)
+    {
+      for (uint i = 0; i < block; ++i)
+      {
+        vec4 s  = tile_samples[(base.y + j) * tile_size + base.x + i];
+        vec2 d  = vec2(base + uvec2(i, j)) - vec2(local);
+        float r = dot(d, d);
+        if (s.a != 0. && r < best)
+        {
+          best  = r;
+          color = s;
+        }
+      }
+    }
+  }
+
+  imageStore(render_target, ivec2(pixel), vec4(color.rgb, 1.));
+}
+
+
+#endif
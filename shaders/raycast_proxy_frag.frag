@@ -0,0 +1,73 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#version 450
+
+#include "raycast_boundary.glsl"
+
+
+// The raster path draws the exterior faces as a linear triangle proxy, so the
+// rasterizer already finds the visible face and a close reference coordinate
+// for each pixel. A few face Newton steps from there take the interpolated
+// guess onto the curved face before shading.
+
+
+layout(location = 0) in vec3 frag_pos;
+layout(location = 1) in vec3 frag_ref;
+layout(location = 2) flat in vec3 frag_ro;
+layout(location = 3) flat in int frag_elem;
+layout(location = 4) flat in int frag_face;
+
+layout(location = 0) out vec4 out_color;
+
+
+const uint proxy_newton_steps = 3;
+
+
+void main()
+{
+  // the proxy has no cut faces, clipped fragments are simply dropped
+
+  if (!clip_visible(frag_pos))
+  {
+    discard;
+  }
+
+  vec3 ro = frag_ro;
+  vec3 rd = normalize(frag_pos - ro);
+
+  vec3 r_p = frag_ref;
+
+  if (!elem_affine(frag_elem))
+  {
+    float res_tol = 1e-4 * ubo.tol_scale;  // relative to the element size
+    aabb  box     = bboxes[frag_elem];
+    float tol2    = res_tol * res_tol * dot(box.h - box.l, box.h - box.l);
+
+    // an unconverged refinement still improves on the proxy, keep it
+
+    vec3 g_p;
+    face_newton(ro, rd, frag_elem, frag_face, proxy_newton_steps, tol2, r_p,
+                g_p);
+  }
+
+  float state[5];
+  interp_state(clamp(r_p, vec3(0.), vec3(1.)), frag_elem, state);
+
+  out_color = map_color(SPEC_OUTPUT, domain_otlim.x, domain_otlim.y, state,
+                        params.gamma);
+}
@@ -0,0 +1,44 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#version 450
+
+layout(set = 0, binding = 0) uniform scene_buffer {
+  mat4 view;
+  mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_color;  // (elem, face, 0) for proxy vertices
+layout(location = 2) in vec3 in_ref;
+
+layout(location = 0) out vec3 frag_pos;
+layout(location = 1) out vec3 frag_ref;
+layout(location = 2) flat out vec3 frag_ro;
+layout(location = 3) flat out int frag_elem;
+layout(location = 4) flat out int frag_face;
+
+void main()
+{
+  gl_Position = ubo.proj * ubo.view * vec4(in_position, 1.);
+
+  frag_pos  = in_position;
+  frag_ref  = in_ref;
+  frag_ro   = inverse(ubo.view)[3].xyz;
+  frag_elem = int(in_color.x);
+  frag_face = int(in_color.y);
+}
@@ -0,0 +1,69 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_SLICE
+#define SHDR_RAYCAST_SLICE
+
+
+#include "raycast_interface_layout.glsl"
+
+#include "intersections.glsl"
+#include "clipping.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+#include "point_location.glsl"
+#include "colormapping.glsl"
+
+
+vec4 raycast(const in vec3 ro, const in vec3 rd)
+{
+  vec3 pp = vec3(0., 0., 0.) + ubo.slice_model[3].xyz;
+  vec3 pn = (ubo.slice_model * vec4(0., 0., 1., 0.)).xyz;
+
+  // determine ray plane intersection point
+
+  float t           = plane_intersect(ro, rd, pp, pn);
+  vec3 intersection = ro + rd * t;
+
+  if (!inside_aabb(intersection, domain_bbox) || t < 0. ||
+      !clip_visible(intersection))
+  {
+    return clear_color;
+  }
+
+  // find the element in which this point occurs
+
+  int elem_num; vec3 hit_pos;
+  bool hit_geom = locate_point(intersection, elem_num, hit_pos);
+
+  if (hit_geom)
+  {
+    float min = domain_otlim.x;
+    float max = domain_otlim.y;
+
+    float state[5];
+    interp_state(hit_pos, elem_num, state);
+
+    return map_color(SPEC_OUTPUT, min, max, state, params.gamma);
+  }
+  else
+  {
+    return clear_color;
+  }
+}
+
+
+#endif
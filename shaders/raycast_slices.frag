@@ -0,0 +1,33 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#version 450
+
+#include "raycast_slices.glsl"
+
+
+layout(location = 0) in vec4 ndc_pos;
+
+layout(location = 0) out vec4 out_color;
+
+
+void main()
+{
+  vec3 ro, rd;
+  find_ray(ndc_pos, ubo.view, ubo.proj, ro, rd);
+
+  out_color = raycast(ro, rd);
+}
@@ -0,0 +1,106 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_RAYCAST_SLICES
+#define SHDR_RAYCAST_SLICES
+
+
+// Slice set rendering. Each ray intersects every plane of the set (see
+// "update_slice_planes" in transform.cpp), sorts the hits inside the domain
+// and composites them front to back as translucent layers. Successive hits
+// start their point location from the previous hit's element and k-d leaf,
+// which closely spaced planes usually share, so the tree is only descended
+// again where a ray crosses into another leaf.
+
+
+#include "raycast_interface_layout.glsl"
+
+#include "intersections.glsl"
+#include "clipping.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+#include "point_location.glsl"
+#include "colormapping.glsl"
+
+
+const uint  max_slices     = 20;   // ubo.slice_planes size
+const float slices_opacity = 0.6;  // per plane
+const float slices_opaque  = 0.99; // early termination opacity
+
+
+vec4 raycast(const in vec3 ro, const in vec3 rd)
+{
+  vec2 domain_bbox_intersect = clipped_aabb_intersect(ro, rd, domain_bbox);
+  if (domain_bbox_intersect.x == -1. && domain_bbox_intersect.y == -1.)
+  {
+    return clear_color;
+  }
+
+  float tmin = max(domain_bbox_intersect.x, 0.);
+  float tmax = domain_bbox_intersect.y;
+
+  // plane hits inside the domain, insertion sorted front to back
+
+  float hits[max_slices];
+  uint  nhits = 0;
+
+  for (uint i = 0; i < min(ubo.nslices, max_slices); ++i)
+  {
+    vec4  plane = ubo.slice_planes[i];
+    float denom = dot(plane.xyz, rd);
+    if (denom == 0.)
+      continue;
+
+    float t = (plane.w - dot(plane.xyz, ro)) / denom;
+    if (t < tmin || t > tmax)
+      continue;
+
+    uint j = nhits++;
+    for (; j > 0 && hits[j - 1] > t; --j)
+      hits[j] = hits[j - 1];
+    hits[j] = t;
+  }
+
+  // composite, locating each hit from the last one found
+
+  float min = domain_otlim.x;
+  float max = domain_otlim.y;
+
+  vec3  color    = vec3(0.);
+  float alpha    = 0.;
+  int   leaf_num = -1;
+  int   elem_num = -1;
+
+  for (uint i = 0; i < nhits && alpha < slices_opaque; ++i)
+  {
+    vec3 r_p;
+    if (!locate_point_near(ro + hits[i] * rd, leaf_num, elem_num, r_p))
+      continue;
+
+    float state[5];
+    interp_state(r_p, elem_num, state);
+    vec3 hit_color = map_color(SPEC_OUTPUT, min, max, state, params.gamma).rgb;
+
+    color += (1. - alpha) * slices_opacity * hit_color;
+    alpha += (1. - alpha) * slices_opacity;
+  }
+
+  return vec4(color + (1. - alpha) * clear_color.rgb, 1.);
+}
+
+
+#endif
@@ -16,91 +16,18 @@
 
 #version 450
 
-#include "raycast_interface_layout.glsl"
+#include "raycast_surface.glsl"
 
-#include "intersections.glsl"
-#include "mapping.glsl"
-#include "colormapping.glsl"
 
+layout(location = 0) in vec4 ndc_pos;
 
-vec3 refbox_nearest_vec(vec3 p)
-{
-  p      = p - 0.5;
-  vec3 b = vec3(0.5);
-
-  return clamp(p, -b, b) - p;
-}
-
-bool intersect_elem(const in vec3 ro, const in vec3 rd, const in int elem_num,
-                    out vec3 r_p, out float t)
-{
-  vec2 bbox_intersect = aabb_intersect(ro, rd, bboxes[elem_num]);
-
-  if (bbox_intersect.x == -1. && bbox_intersect.y == -1.)
-  {
-    return false;
-  }
-
-  r_p        = vec3(0.5);  // starting reference guess
-  t          = bbox_intersect.x;
-  float tmax = bbox_intersect.y;
-
-  const uint max_rounds = 50;
-        uint max_steps  = 2;
-  const float damp      = 0.5;
-  const float hit_tol   = 5e-3;
-
-  uint round    = 0;
-  bool hit      = false;
-  while (t < tmax && round < max_rounds)
-  {
-    mat3 j;
-    vec3 g_p, g_target = ro + t * rd;
-    for (uint step = 0; step < max_steps; ++step)
-    {
-      mapinfo(r_p, elem_num, params.q, g_p, j);
+layout(location = 0) out vec4 out_color;
 
-      r_p -= inverse(j) * (g_p - g_target);
-    }
-
-    hit = r_p.x > 0. - hit_tol && r_p.x < 1. + hit_tol &&
-          r_p.y > 0. - hit_tol && r_p.y < 1. + hit_tol &&
-          r_p.z > 0. - hit_tol && r_p.z < 1. + hit_tol;
-
-    if (hit)
-      break;
-    else
-      t += damp * length(j * refbox_nearest_vec(r_p));
-
-    ++round;
-    max_steps = 1;
-  }
-
-  return hit;
-}
-
-#include "kd_traversal.glsl"
 
 void main()
 {
   vec3 ro, rd;
   find_ray(ndc_pos, ubo.view, ubo.proj, ro, rd);
 
-  int elem_num; bool hit_geom; vec3 hit_pos; float thit;
-  kd_ray_traverse(ro, rd, elem_num, hit_geom, hit_pos, thit);
-
-  if (hit_geom)
-  {
-    float min = domain_otlim.x;
-    float max = domain_otlim.y;
-
-    float state[5];
-    interp_state(hit_pos, elem_num, params.p, state);
-
-    out_color = map_color(output_option, min, max, state, params.gamma);
-  }
-  else
-  {
-    out_color = clear_color;
-  }
+  out_color = raycast(ro, rd);
 }
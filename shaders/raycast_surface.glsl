@@ -0,0 +1,188 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_SURFACE
+#define SHDR_RAYCAST_SURFACE
+
+
+#include "raycast_interface_layout.glsl"
+
+#include "intersections.glsl"
+#include "clipping.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+#include "colormapping.glsl"
+
+
+vec3 refbox_nearest_vec(vec3 p)
+{
+  p      = p - 0.5;
+  vec3 b = vec3(0.5);
+
+  return clamp(p, -b, b) - p;
+}
+
+// Marches the ray point through the element from t (and reference guess r_p)
+// until the Newton solution for it lands inside the reference cube.
+bool march_elem(const in vec3 ro, const in vec3 rd, const in int elem_num,
+                const in float tmax, const in uint max_rounds,
+                inout vec3 r_p, inout float t)
+{
+        uint max_steps  = 2;
+  const float damp      = 0.5;
+        float hit_tol   = 5e-3 * ubo.tol_scale;
+
+  uint round    = 0;
+  bool hit      = false;
+  while (t < tmax && round < max_rounds)
+  {
+    mat3 j;
+    vec3 g_p, g_target = ro + t * rd;
+    for (uint step = 0; step < max_steps; ++step)
+    {
+      mapinfo(r_p, elem_num, g_p, j);
+
+      r_p -= inverse(j) * (g_p - g_target);
+    }
+
+    hit = r_p.x > 0. - hit_tol && r_p.x < 1. + hit_tol &&
+          r_p.y > 0. - hit_tol && r_p.y < 1. + hit_tol &&
+          r_p.z > 0. - hit_tol && r_p.z < 1. + hit_tol;
+
+    if (hit)
+      break;
+    else
+      t += damp * length(j * refbox_nearest_vec(r_p));
+
+    ++round;
+    max_steps = 1;
+  }
+
+  return hit;
+}
+
+// Elements are solid, so an element cut by the clip region is entered where
+// the ray enters the region and shows its interior there.
+bool intersect_elem(const in vec3 ro, const in vec3 rd, const in int elem_num,
+                    out vec3 r_p, out float t)
+{
+  vec2 bbox_intersect = clipped_aabb_intersect(ro, rd, bboxes[elem_num]);
+
+  if (bbox_intersect.x == -1. && bbox_intersect.y == -1.)
+  {
+    return false;
+  }
+
+  // affine elements map the ray to a line in reference space, intersect the
+  // reference cube directly
+
+  if (elem_affine(elem_num))
+  {
+    vec3 ro_ref, rd_ref;
+    affine_ray2ref(ro, rd, elem_num, ro_ref, rd_ref);
+
+    aabb refbox;
+    refbox.l = vec3(0.);
+    refbox.h = vec3(1.);
+
+    vec2 ref_intersect = aabb_intersect(ro_ref, rd_ref, refbox);
+    if (ref_intersect.x == -1. && ref_intersect.y == -1.)
+    {
+      return false;
+    }
+
+    // the reference ray shares the physical ray's parameter
+
+    ref_intersect.x = max(ref_intersect.x, bbox_intersect.x);
+    if (ref_intersect.x > min(ref_intersect.y, bbox_intersect.y))
+    {
+      return false;
+    }
+
+    t   = ref_intersect.x;
+    r_p = clamp(ro_ref + t * rd_ref, vec3(0.), vec3(1.));
+    return true;
+  }
+
+  t   = bbox_intersect.x;
+  r_p = warm_start(ro + t * rd, elem_num);  // starting reference guess
+
+  return march_elem(ro, rd, elem_num, bbox_intersect.y, ubo.surface_rounds,
+                    r_p, t);
+}
+
+// Intersection seeded by an earlier hit on the same element (temporal reuse).
+// The march starts from the earlier reference point slightly before the
+// earlier hit so a surface that moved towards the camera is still entered
+// from the front. Only a few rounds are allowed, callers fall back to a full
+// traversal on failure.
+bool intersect_elem_warm(const in vec3 ro, const in vec3 rd,
+                         const in int elem_num, const in vec3 ref_guess,
+                         const in float t_guess, out vec3 r_p, out float t)
+{
+  if (elem_affine(elem_num))
+  {
+    return intersect_elem(ro, rd, elem_num, r_p, t);
+  }
+
+  vec2 bbox_intersect = clipped_aabb_intersect(ro, rd, bboxes[elem_num]);
+
+  if (bbox_intersect.x == -1. && bbox_intersect.y == -1.)
+  {
+    return false;
+  }
+
+  aabb  box     = bboxes[elem_num];
+  float backoff = 0.05 * length(box.h - box.l);
+
+  t   = clamp(t_guess - backoff, bbox_intersect.x, bbox_intersect.y);
+  r_p = ref_guess;
+
+  return march_elem(ro, rd, elem_num, bbox_intersect.y, 8, r_p, t);
+}
+
+#include "kd_traversal.glsl"
+
+
+vec4 shade_hit(const in vec3 ro, const in vec3 rd, const in int elem_num,
+               const in vec3 hit_pos, const in float thit)
+{
+  float min = domain_otlim.x;
+  float max = domain_otlim.y;
+
+  float state[5];
+  interp_state(hit_pos, elem_num, state);
+
+  return map_color(SPEC_OUTPUT, min, max, state, params.gamma);
+}
+
+vec4 raycast(const in vec3 ro, const in vec3 rd)
+{
+  int elem_num; bool hit_geom; vec3 hit_pos; float thit;
+  kd_ray_traverse(ro, rd, elem_num, hit_geom, hit_pos, thit);
+
+  if (hit_geom)
+  {
+    return shade_hit(ro, rd, elem_num, hit_pos, thit);
+  }
+  else
+  {
+    return clear_color;
+  }
+}
+
+
+#endif
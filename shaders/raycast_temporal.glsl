@@ -0,0 +1,100 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_TEMPORAL
+#define SHDR_RAYCAST_TEMPORAL
+
+
+// Temporal compute entry point shared by the raycast_*_temporal.comp shaders.
+// The includer provides "intersect_elem_warm", "shade_hit" and the k-d
+// traversal through one of the raycast_<mode>.glsl files. Tiles are laid out
+// as in the tiled path, each ray first tries its reprojected hit from the
+// previous frame (see temporal.glsl).
+
+
+#include "raycast_tile.glsl"
+#include "temporal.glsl"
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  if (pixel.x >= uint(size.x) || pixel.y >= uint(size.y))
+    return;
+
+  uint pixel_num = pixel.y * uint(size.x) + pixel.x;
+
+  temporal_hit record;
+  record.pos  = vec3(0.);
+  record.elem = -1;
+  record.ref  = vec3(0.);
+  record.age  = 0;
+
+  vec4 color = clear_color;
+
+  if (!tile_culled)
+  {
+    vec3 ro, rd;
+    find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview,
+                     tile_iproj, ro, rd);
+
+    int elem_num = -1; bool hit_geom = false; vec3 hit_pos; float thit;
+
+    // reuse the reprojected hit while it is young enough
+
+    uint src = reproj_src[pixel_num];
+    if (src != temporal_none)
+    {
+      temporal_hit prev = hits[temporal_prev(src)];
+      if (prev.age < temporal_max_age)
+      {
+        float t_guess = dot(prev.pos - ro, rd);
+        hit_geom = intersect_elem_warm(ro, rd, prev.elem, prev.ref, t_guess,
+                                       hit_pos, thit);
+        elem_num   = prev.elem;
+        record.age = prev.age + 1;
+      }
+    }
+
+    // full traversal, refresh ages are staggered across pixels
+
+    if (!hit_geom)
+    {
+      kd_ray_traverse(ro, rd, elem_num, hit_geom, hit_pos, thit);
+      record.age = (pixel_num * 2654435761u) >> 29;
+    }
+
+    if (hit_geom)
+    {
+      record.pos  = ro + thit * rd;
+      record.elem = elem_num;
+      record.ref  = hit_pos;
+
+      color = shade_hit(ro, rd, elem_num, hit_pos, thit);
+    }
+  }
+
+  hits[temporal_cur(pixel_num)] = record;
+  imageStore(render_target, ivec2(pixel), color);
+}
+
+
+#endif
@@ -0,0 +1,116 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_TILE
+#define SHDR_RAYCAST_TILE
+
+
+// Screen tile layout shared by the compute raycast entry points. Each
+// workgroup covers a tile_size x tile_size block of the render image and
+// assigns pixels to invocations in Morton order so subgroups trace compact
+// blocks of neighboring rays. The inverse camera transforms and a
+// conservative tile frustum / domain box test are computed once per tile by
+// tile_begin.
+
+
+#include "raycast_interface_layout.glsl"
+#include "raycast_target.glsl"
+#include "intersections.glsl"
+
+
+const uint tile_size = 8;
+
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+shared mat4 tile_iview;
+shared mat4 tile_iproj;
+shared bool tile_culled;
+
+
+uvec2 morton_decode(const in uint i)
+{
+  uint x = (i & 1u) | ((i >> 1) & 2u) | ((i >> 2) & 4u);
+  uint y = ((i >> 1) & 1u) | ((i >> 2) & 2u) | ((i >> 3) & 4u);
+  return uvec2(x, y);
+}
+
+vec4 pixel_ndc(const in vec2 pixel, const in ivec2 size)
+{
+  return vec4(2. * pixel / vec2(size) - 1., 0., 1.);
+}
+
+// True if the domain bounding box lies entirely outside one of the four side
+// planes of the frustum through the tile's corner rays.
+bool tile_outside_domain(const in uvec2 tile, const in ivec2 size)
+{
+  vec2 lo = vec2(tile * tile_size);
+  vec2 hi = min(lo + float(tile_size), vec2(size));
+
+  vec2 corners[4] = vec2[4](lo, vec2(hi.x, lo.y), hi, vec2(lo.x, hi.y));
+
+  vec3 ro[4], rd[4];
+  for (uint i = 0; i < 4; ++i)
+  {
+    find_ray_inverse(pixel_ndc(corners[i], size), tile_iview, tile_iproj,
+                     ro[i], rd[i]);
+  }
+
+  vec3 cro, crd;
+  find_ray_inverse(pixel_ndc(0.5 * (lo + hi), size), tile_iview, tile_iproj,
+                   cro, crd);
+  vec3 inside = cro + crd;
+
+  for (uint i = 0; i < 4; ++i)
+  {
+    uint j = (i + 1) % 4;
+    vec3 n = cross(rd[i], ro[j] - ro[i]);
+    if (dot(n, inside - ro[i]) < 0.)
+      n = -n;
+
+    bool outside = true;
+    for (uint c = 0; c < 8; ++c)
+    {
+      vec3 corner = vec3((c & 1u) == 0u ? domain_bbox.l.x : domain_bbox.h.x,
+                         (c & 2u) == 0u ? domain_bbox.l.y : domain_bbox.h.y,
+                         (c & 4u) == 0u ? domain_bbox.l.z : domain_bbox.h.z);
+      if (dot(n, corner - ro[i]) >= 0.)
+      {
+        outside = false;
+        break;
+      }
+    }
+
+    if (outside)
+      return true;
+  }
+
+  return false;
+}
+
+// Fills the shared tile data, must be reached by every invocation.
+void tile_begin(const in uvec2 tile, const in ivec2 size)
+{
+  if (gl_LocalInvocationIndex == 0)
+  {
+    tile_iview  = inverse(ubo.view);
+    tile_iproj  = inverse(ubo.proj);
+    tile_culled = tile_outside_domain(tile, size);
+  }
+  barrier();
+}
+
+
+#endif
@@ -0,0 +1,98 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_RAYCAST_UPSAMPLE
+#define SHDR_RAYCAST_UPSAMPLE
+
+
+// Upsampling compute entry point shared by the raycast_*_upsample.comp shaders
+// (see upsample.glsl). The includer provides "raycast" through one of the
+// raycast_<mode>.glsl files. Workgroups tile the full resolution image.
+
+
+#include "constants.glsl"
+#include "raycast_tile.glsl"
+#include "upsample.glsl"
+
+
+void main()
+{
+  ivec2 size  = imageSize(upscaled_target);
+  ivec2 gsize = imageSize(guide_image);
+  uvec2 tile  = gl_WorkGroupID.xy;
+  uvec2 pixel = tile * tile_size + morton_decode(gl_LocalInvocationIndex);
+
+  tile_begin(tile, size);
+
+  if (pixel.x >= uint(size.x) || pixel.y >= uint(size.y))
+    return;
+
+  // guide pixels around this pixel's center, both images span the same view
+
+  vec2  g  = (vec2(pixel) + 0.5) * vec2(gsize) / vec2(size);
+  ivec2 gn = clamp(ivec2(g), ivec2(0), gsize - 1);
+
+  vec4 nearest = imageLoad(guide_image, gn);
+  if (upsample_overlay(nearest))
+  {
+    imageStore(upscaled_target, ivec2(pixel), vec4(nearest.rgb, 1.));
+    return;
+  }
+
+  g        -= 0.5;
+  ivec2 g0  = clamp(ivec2(floor(g)), ivec2(0), gsize - 1);
+  ivec2 g1  = min(g0 + 1, gsize - 1);
+  vec2  f   = clamp(g - vec2(g0), 0., 1.);
+
+  vec4 guide[4] = vec4[4](imageLoad(guide_image, g0),
+                          imageLoad(guide_image, ivec2(g1.x, g0.y)),
+                          imageLoad(guide_image, ivec2(g0.x, g1.y)),
+                          imageLoad(guide_image, g1));
+  float w[4]    = float[4]((1. - f.x) * (1. - f.y), f.x * (1. - f.y),
+                           (1. - f.x) * f.y,        f.x * f.y);
+
+  bool ambiguous = false;
+  vec3 lo = vec3(FLT_MAX), hi = vec3(-FLT_MAX);
+  vec3 color = vec3(0.);
+  for (uint i = 0; i < 4; ++i)
+  {
+    ambiguous  = ambiguous || upsample_overlay(guide[i]);
+    lo         = min(lo, guide[i].rgb);
+    hi         = max(hi, guide[i].rgb);
+    color     += w[i] * guide[i].rgb;
+  }
+
+  ambiguous = ambiguous || any(greaterThan(hi - lo, vec3(upsample_color_tol)));
+
+  vec4 result = vec4(color, 1.);
+  if (ambiguous)
+  {
+    result = clear_color;
+    if (!tile_culled)
+    {
+      vec3 ro, rd;
+      find_ray_inverse(pixel_ndc(vec2(pixel) + 0.5, size), tile_iview,
+                       tile_iproj, ro, rd);
+
+      result = raycast(ro, rd);
+    }
+  }
+
+  imageStore(upscaled_target, ivec2(pixel), result);
+}
+
+
+#endif
@@ -0,0 +1,151 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_RAYCAST_VOLUME
+#define SHDR_RAYCAST_VOLUME
+
+
+// Direct volume rendering. Rays walk the k-d tree leaves front to back and
+// sample the field inside each leaf's ray segment, compositing a transfer
+// function (colormap color, opacity ramping up from "volume_cutoff") front to
+// back. Elements whose output range lies entirely below the cutoff are never
+// sampled and leaves holding only such elements are skipped outright. The
+// step follows the element last sampled, a fixed number of samples per
+// polynomial order across its smallest extent, and the ray stops once it is
+// nearly opaque.
+
+
+#include "raycast_interface_layout.glsl"
+
+#include "intersections.glsl"
+#include "clipping.glsl"
+#include "mapping.glsl"
+#include "inverse_map.glsl"
+#include "point_location.glsl"
+#include "colormapping.glsl"
+#include "kd_stepping.glsl"
+
+
+const float volume_cutoff      = 0.25;  // normalized output, transparent below
+const float volume_density     = 8.;    // extinction at the maximum output,
+                                        // per domain diagonal
+const float volume_samples     = 2.;    // per polynomial order across elements
+const float volume_opaque      = 0.99;  // early termination opacity
+const uint  volume_max_samples = 2048;
+
+
+// normalized output
+float volume_intensity(const in float val)
+{
+  return (val - domain_otlim.x) / (domain_otlim.y - domain_otlim.x);
+}
+
+float volume_extinction(const in float intensity)
+{
+  float ramp = max(intensity - volume_cutoff, 0.) / (1. - volume_cutoff);
+  return volume_density * ramp / length(domain_bbox.h - domain_bbox.l);
+}
+
+// zero opacity over the element's whole output range
+bool elem_transparent(const in int elem_num)
+{
+  return volume_intensity(otp_bounds[elem_num].y) <= volume_cutoff;
+}
+
+float elem_step(const in int elem_num)
+{
+  vec3 extent = bboxes[elem_num].h - bboxes[elem_num].l;
+  return min(extent.x, min(extent.y, extent.z)) /
+         (volume_samples * float(max(SPEC_P, 1u)));
+}
+
+vec4 raycast(const in vec3 ro, const in vec3 rd)
+{
+  vec2 domain_bbox_intersect = clipped_aabb_intersect(ro, rd, domain_bbox);
+  if (domain_bbox_intersect.x == -1. && domain_bbox_intersect.y == -1.)
+  {
+    return clear_color;
+  }
+
+  vec3  color    = vec3(0.);
+  float alpha    = 0.;
+  uint  nsamples = 0;
+
+  float domain_tmax = domain_bbox_intersect.y;
+  float tmin        = max(domain_bbox_intersect.x, 0.);
+  float tmax        = domain_tmax;
+  int   node_num    = 0;
+
+  while (kd_next_leaf(ro, rd, node_num, tmin, tmax))
+  {
+    kdnode node = kdnodes[node_num];
+
+    // empty space skipping, the leaf's finest visible element sets the step
+    // through gaps between elements
+
+    float leaf_step = FLT_MAX;
+    for (uint i = 0; i < node.count; ++i)
+    {
+      int elem_num = kdleafelems[node.offset + i];
+      if (!elem_transparent(elem_num))
+        leaf_step = min(leaf_step, elem_step(elem_num));
+    }
+
+    float t = tmin;
+    while (leaf_step < FLT_MAX && t < tmax && alpha < volume_opaque &&
+           nsamples < volume_max_samples)
+    {
+      vec3  p  = ro + t * rd;
+      float dt = leaf_step;
+
+      for (uint i = 0; i < node.count; ++i)
+      {
+        int  elem_num = kdleafelems[node.offset + i];
+        vec3 r_p;
+        if (elem_transparent(elem_num) || !point_in_elem(p, elem_num, r_p))
+          continue;
+
+        dt = elem_step(elem_num);
+
+        float state[5];
+        interp_state(clamp(r_p, vec3(0.), vec3(1.)), elem_num, state);
+        float intensity =
+        volume_intensity(eval_output(SPEC_OUTPUT, state, params.gamma));
+
+        float a = 1. - exp(-volume_extinction(intensity) * dt);
+        color  += (1. - alpha) * a * sample_colormap(intensity);
+        alpha  += (1. - alpha) * a;
+
+        break;
+      }
+
+      t += dt;
+      ++nsamples;
+    }
+
+    if (alpha >= volume_opaque || nsamples >= volume_max_samples ||
+        !kd_leave_leaf(ro, rd, domain_tmax, node_num, tmin, tmax))
+    {
+      break;
+    }
+  }
+
+  return vec4(color + (1. - alpha) * clear_color.rgb, 1.);
+}
+
+
+#endif
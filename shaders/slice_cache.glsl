@@ -0,0 +1,52 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_SLICE_CACHE
+#define SHDR_SLICE_CACHE
+
+
+// Slice plane cache. The fill pass resamples the output onto a square grid of
+// texels aligned with the slice plane, centered on the plane origin and wide
+// enough to cover the domain wherever the plane cuts it. It only runs when
+// the plane changes, the view pass then intersects each pixel's ray with the
+// plane and interpolates the cached values. Texels store the output value
+// and whether the point lies inside an element.
+
+
+layout(std430, set = 3, binding = 0) buffer slice_cache_texels {
+  vec2 slice_texels[];  // output value, coverage
+};
+
+layout(push_constant) uniform slice_cache_constants {
+  uint size;  // texels along each side
+} sc;
+
+
+void slice_frame(out vec3 origin, out vec3 u_axis, out vec3 v_axis,
+                 out float half_width)
+{
+  origin = ubo.slice_model[3].xyz;
+  u_axis = normalize(ubo.slice_model[0].xyz);
+  v_axis = normalize(ubo.slice_model[1].xyz);
+
+  vec3 cntr  = 0.5 * (domain_bbox.l + domain_bbox.h);
+  half_width = 0.5 * length(domain_bbox.h - domain_bbox.l) +
+               length(cntr - origin);
+}
+
+
+#endif
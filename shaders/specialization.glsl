@@ -0,0 +1,38 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_SPECIALIZATION
+#define SHDR_SPECIALIZATION
+
+
+// Set at pipeline creation from the loaded solution (see
+// specialization_constants in pipeline.cpp, ids must stay in sync). Fixing the
+// orders here lets the driver resolve the basis selection and fully unroll the
+// tensor product loops for each variant.
+
+layout(constant_id = 0) const uint SPEC_P        = 1;      // solution order
+layout(constant_id = 1) const uint SPEC_Q        = 1;      // geometry order
+layout(constant_id = 2) const int  SPEC_OUTPUT   = 0;      // output_type
+layout(constant_id = 3) const bool SPEC_MONOMIAL = false;  // monomial coeffs
+
+const uint SPEC_PP1  = SPEC_P + 1;
+const uint SPEC_QP1  = SPEC_Q + 1;
+const uint SPEC_NBFP = SPEC_PP1 * SPEC_PP1 * SPEC_PP1;
+const uint SPEC_NBFQ = SPEC_QP1 * SPEC_QP1 * SPEC_QP1;
+
+
+#endif
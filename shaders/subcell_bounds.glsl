@@ -0,0 +1,62 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#ifndef SHDR_SUBCELL_BOUNDS
+#define SHDR_SUBCELL_BOUNDS
+
+
+// Two level output range hierarchy below each element's overall bounds, the
+// element's reference cube is split into 2x2x2 octants and each octant into
+// 2x2x2 leaf subcells. metadata.comp fills it with strict ranges (Bernstein
+// coefficient bounds), the isosurface mode descends it along the ray so it
+// only seeds Newton where the isovalue can occur.
+// Includers declare the "subcell_bounds" buffer, per element the 8 octant
+// ranges followed by the 8 leaf ranges of each octant.
+
+
+const uint subcell_bounds_size = 8 + 8 * 8;
+
+
+// reference space box of octant "o" or of leaf "c" within octant "o"
+aabb octant_box(const in uint o)
+{
+  aabb box;
+  box.l = 0.5 * vec3(o & 1u, (o >> 1) & 1u, (o >> 2) & 1u);
+  box.h = box.l + vec3(0.5);
+  return box;
+}
+
+aabb leaf_box(const in uint o, const in uint c)
+{
+  aabb box;
+  box.l = octant_box(o).l + 0.25 * vec3(c & 1u, (c >> 1) & 1u, (c >> 2) & 1u);
+  box.h = box.l + vec3(0.25);
+  return box;
+}
+
+vec2 octant_bounds(const in int elem, const in uint o)
+{
+  return subcell_bounds[subcell_bounds_size * elem + o];
+}
+
+vec2 leaf_bounds(const in int elem, const in uint o, const in uint c)
+{
+  return subcell_bounds[subcell_bounds_size * elem + 8 + 8 * o + c];
+}
+
+
+#endif
@@ -0,0 +1,89 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_TEMPORAL
+#define SHDR_TEMPORAL
+
+
+// Temporal hit reuse. Every frame the temporal raycaster writes a hit record
+// per pixel into one half of hits[]. The next frame first scatters the
+// previous half's hit positions into the new view:
+//
+//   temporal_reproject_depth - nearest reprojected view depth per pixel
+//   temporal_reproject       - the previous pixel that won each new pixel
+//
+// Each ray then tries the element its reprojected hit came from, seeded with
+// that hit's reference coordinates, and only traverses the k-d tree if that
+// fails. Records are refreshed by full traversal after temporal_max_age reuses
+// (staggered across pixels) so geometry uncovered by the motion is picked up.
+
+
+#include "data_structures.glsl"
+#include "raycast_interface_layout.glsl"
+#include "raycast_target.glsl"
+
+
+const uint temporal_width   = 64;  // local size of the per pixel kernels
+const uint temporal_max_age = 8;
+const uint temporal_none    = 0xffffffffu;
+
+layout(std430, set = 3, binding = 0) buffer thit_data    { temporal_hit hits[]; };
+layout(std430, set = 3, binding = 1) buffer tdepth_data  { uint reproj_depth[]; };
+layout(std430, set = 3, binding = 2) buffer tsource_data { uint reproj_src[];   };
+
+layout(push_constant) uniform temporal_constants {
+  uint current;  // half of hits[] written this frame, the other is read
+} tc;
+
+
+uint temporal_npixel()
+{
+  return uint(reproj_src.length());
+}
+
+uint temporal_prev(const in uint pixel)
+{
+  return (1 - tc.current) * temporal_npixel() + pixel;
+}
+
+uint temporal_cur(const in uint pixel)
+{
+  return tc.current * temporal_npixel() + pixel;
+}
+
+// Pixel of the current view a global position lands in, temporal_none if it
+// is off screen or behind the camera. Also returns its view depth bits.
+uint temporal_project(const in vec3 pos, out uint depth)
+{
+  ivec2 size = imageSize(render_target);
+
+  vec4 v    = ubo.view * vec4(pos, 1.);
+  vec4 clip = ubo.proj * v;
+  depth     = floatBitsToUint(max(-v.z, 0.));
+
+  if (clip.w <= 0.)
+    return temporal_none;
+
+  vec2 pixel = 0.5 * (clip.xy / clip.w + 1.) * vec2(size);
+  if (pixel.x < 0. || pixel.y < 0. ||
+      pixel.x >= float(size.x) || pixel.y >= float(size.y))
+    return temporal_none;
+
+  return uint(pixel.y) * uint(size.x) + uint(pixel.x);
+}
+
+
+#endif
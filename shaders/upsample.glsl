@@ -0,0 +1,42 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_UPSAMPLE
+#define SHDR_UPSAMPLE
+
+
+// Edge aware upsampling of a downscaled render image. Every pixel of the full
+// resolution image is filled from its four nearest render image (guide)
+// pixels: where their colors agree they are interpolated bilinearly,
+// otherwise (silhouettes, element edges, isosurface folds) the pixel is traced
+// at full resolution. The ui pass marks its pixels with zero alpha, those are
+// kept as drawn and never blended into the scene.
+
+
+layout(set = 3, binding = 0, rgba16f) uniform readonly  image2D guide_image;
+layout(set = 3, binding = 1, rgba16f) uniform writeonly image2D upscaled_target;
+
+
+// largest per channel color spread among the guide pixels still interpolated
+const float upsample_color_tol = 0.05;
+
+bool upsample_overlay(const in vec4 guide)
+{
+  return guide.a < 0.5;
+}
+
+
+#endif
@@ -0,0 +1,31 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_VISIBILITY
+#define SHDR_VISIBILITY
+
+
+// Visibility buffer of the deferred raycaster. The trace pass stores each
+// pixel's closest hit (element, reference coordinates and ray parameter) and
+// the shade pass colors the pixels from it, rebuilding the ray from the view.
+// Frames that only change shading (the colormap) re-run the shade pass alone.
+
+
+layout(std430, set = 3, binding = 0) buffer vishit_data  { vec4 vis_hit[];  };
+layout(std430, set = 3, binding = 1) buffer viselem_data { int  vis_elem[]; };
+
+
+#endif
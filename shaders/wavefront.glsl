@@ -0,0 +1,94 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_WAVEFRONT
+#define SHDR_WAVEFRONT
+
+
+// Wavefront raycasting. Instead of one invocation carrying a ray through
+// traversal, intersection and shading, rays live in a buffer and move through
+// separate kernels:
+//
+//   generate  - one ray per pixel, rays missing the domain are dropped
+//   traverse  - advance each queued ray to its next k-d leaf and request
+//               intersections for up to wavefront_chunk of its elements
+//   intersect - one invocation per (ray, element) request, densely packed
+//   resolve   - keep the closest hit, finish the leaf or step past it
+//   compact   - gather surviving rays into the other queue half
+//   shade     - one invocation per pixel from the final ray records
+//
+// Request counts and survivor flags are turned into offsets by an atomic-free
+// two level prefix sum (scan_local / scan_blocks) which also writes the
+// indirect dispatch arguments for the following stage.
+
+
+#include "data_structures.glsl"
+
+
+const uint wavefront_chunk = 4;     // must match source/wavefront.cpp
+const uint scan_block      = 1024;  // elements per scan_local workgroup
+const uint wavefront_width = 64;    // local size of the per ray kernels
+
+layout(std430, set = 3, binding = 0) buffer wavefront_ray_data {
+  wavefront_ray rays[];
+};
+layout(std430, set = 3, binding = 1) buffer queue_data   { uint queue[];      };
+layout(std430, set = 3, binding = 2) buffer value_data   { uint values[];     };
+layout(std430, set = 3, binding = 3) buffer offset_data  { uint offsets[];    };
+layout(std430, set = 3, binding = 4) buffer block_data   { uint block_sums[]; };
+layout(std430, set = 3, binding = 5) buffer item_data    { vec4 items[];      };
+layout(std430, set = 3, binding = 6) buffer counter_data {
+  uvec4 ray_dispatch[2];   // per queue half, xyz = dispatch, w = ray count
+  uvec4 scan_dispatch[2];  // per queue half, xyz = scan_local dispatch
+  uvec4 item_dispatch;     // xyz = dispatch, w = intersection request count
+} counters;
+
+layout(push_constant) uniform wavefront_constants {
+  uint queue;        // input queue half, compaction writes the other half
+  uint scan_target;  // scan_blocks destination, 0 = items, 1 = output queue
+} wf;
+
+
+uint queue_size()
+{
+  return uint(rays.length());
+}
+
+uint queue_in(const in uint slot)
+{
+  return queue[wf.queue * queue_size() + slot];
+}
+
+uint ray_count()
+{
+  return counters.ray_dispatch[wf.queue].w;
+}
+
+// exclusive prefix sum of values[] after scan_local / scan_blocks
+uint scan_offset(const in uint i)
+{
+  return offsets[i] + block_sums[i / scan_block];
+}
+
+uint items_of(const in uint slot)
+{
+  uint next = (slot + 1 < ray_count()) ? scan_offset(slot + 1)
+                                       : counters.item_dispatch.w;
+  return next - scan_offset(slot);
+}
+
+
+#endif
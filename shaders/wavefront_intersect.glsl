@@ -0,0 +1,66 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_WAVEFRONT_INTERSECT
+#define SHDR_WAVEFRONT_INTERSECT
+
+
+// Wavefront intersection entry point, the includer provides
+// "intersect_elem(ro, rd, elem, r_p, t)" through a raycast_<mode>.glsl file.
+// One invocation handles one (ray, element) request so Newton iterations on
+// curved elements run densely packed regardless of which rays issued them.
+
+
+#include "constants.glsl"
+#include "wavefront.glsl"
+
+
+layout(local_size_x = wavefront_width, local_size_y = 1, local_size_z = 1) in;
+
+
+void main()
+{
+  uint i = gl_GlobalInvocationID.x;
+
+  if (i >= counters.item_dispatch.w)
+    return;
+
+  // requesting queue slot, the last one whose offset is <= i
+
+  uint lo = 0;
+  uint hi = ray_count();
+  while (hi - lo > 1)
+  {
+    uint mid = (lo + hi) / 2;
+    if (scan_offset(mid) <= i)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  wavefront_ray ray = rays[queue_in(lo)];
+  kdnode leaf       = kdnodes[ray.node];
+  int elem_num      =
+  kdleafelems[leaf.offset + ray.cursor + (i - scan_offset(lo))];
+
+  vec3 r_p; float t = FLT_MAX;
+  bool hit = intersect_elem(ray.ro, ray.rd, elem_num, r_p, t);
+
+  items[i] = vec4(r_p, hit ? t : FLT_MAX);
+}
+
+
+#endif
@@ -0,0 +1,63 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#ifndef SHDR_WAVEFRONT_SHADE
+#define SHDR_WAVEFRONT_SHADE
+
+
+// Wavefront shading entry point, the includer provides
+// "shade_hit(ro, rd, elem, hit_pos, thit)" and "kd_ray_traverse" through a
+// raycast_<mode>.glsl file. Rays still unfinished after the last traversal
+// round (deep isosurface rays) are traced to completion here.
+
+
+#include "raycast_target.glsl"
+#include "wavefront.glsl"
+
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+
+void main()
+{
+  ivec2 size  = imageSize(render_target);
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+
+  if (pixel.x >= size.x || pixel.y >= size.y)
+    return;
+
+  wavefront_ray ray = rays[pixel.y * size.x + pixel.x];
+
+  if (ray.node >= 0)
+  {
+    bool hit_geom;
+    kd_ray_traverse(ray.ro, ray.rd, ray.elem, hit_geom, ray.hit_pos,
+                    ray.thit);
+    if (!hit_geom)
+      ray.elem = -1;
+  }
+
+  vec4 color = clear_color;
+  if (ray.elem >= 0)
+  {
+    color = shade_hit(ray.ro, ray.rd, ray.elem, ray.hit_pos, ray.thit);
+  }
+
+  imageStore(render_target, pixel, color);
+}
+
+
+#endif
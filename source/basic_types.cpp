@@ -39,7 +39,70 @@ enum struct raycast_mode
 {
   surface,
   slice,
-  isosurface
+  isosurface,
+  boundary,
+  volume,
+  slices
+};
+
+const u32 nraycast_modes = 6;
+
+const char* const raycast_mode_names[nraycast_modes] = {
+"surface",
+"slice",
+"isosurface",
+"boundary",
+"volume",
+"slices",
+};
+
+
+// how the raycast modes are dispatched
+
+enum struct raycast_path
+{
+  fragment,     // full screen fragment canvas
+  tiled,        // compute over 8x8 screen tiles
+  wavefront,    // separate traverse / intersect / shade kernels
+  cooperative,  // tiles evaluate elements from shared memory
+  binned,       // tiles intersect per tile element lists
+  packet,       // subgroups traverse the k-d tree as ray packets
+  temporal,     // tiles first retry last frame's reprojected hit
+  deferred,     // visibility buffer retraced when the view changes
+  progressive,  // one pixel per block, refined while the view is still
+  raster,       // rasterized boundary face proxy
+  cached,       // slice plane cache resampled when the plane moves
+  mesh          // isosurface mesh extracted when the isovalues change
+};
+
+const u32 nraycast_paths = 12;
+
+const char* const raycast_path_names[nraycast_paths] = {
+"fragment",
+"tiled",
+"wavefront",
+"cooperative",
+"binned",
+"packet",
+"temporal",
+"deferred",
+"progressive",
+"raster",
+"cached",
+"mesh",
+};
+
+// slice, slices and volume locate points: no wavefront through deferred
+// boundary traces faces, not elements: no wavefront, cooperative or binned
+// raster draws the exterior faces: surface and boundary only
+// cached needs a plane, mesh a contour: slice and isosurface only
+const bool raycast_path_supported[nraycast_modes][nraycast_paths] = {
+{true, true, true,  true,  true,  true,  true,  true,  true, true,  false, false},
+{true, true, false, false, false, false, false, false, true, false, true,  false},
+{true, true, true,  true,  true,  true,  true,  true,  true, false, false, true},
+{true, true, false, false, false, true,  true,  true,  true, true,  false, false},
+{true, true, false, false, false, false, false, false, true, false, false, false},
+{true, true, false, false, false, false, false, false, true, false, false, false},
 };
 
 
@@ -110,6 +173,45 @@ struct kdnode
 };
 
 
+// coarse inverse map lattice stored per curved element (see inverse_map.glsl)
+const u32 warm_table_size = 3 * 3 * 3;
+
+// octant and leaf subcell output ranges stored per element (see
+// subcell_bounds.glsl)
+const u32 subcell_bounds_size = 8 + 8 * 8;
+
+struct elem_inverse_map
+{
+  glm::vec4 ij[3];   // center inverse Jacobian columns (exact if affine),
+                     // w the linearization error along each global axis
+  glm::vec4 origin;  // global position of reference origin, w = 1 if affine
+};
+
+// ray record of the wavefront raycaster (see wavefront.glsl)
+struct wavefront_ray
+{
+  glm::vec3 ro;
+  float     tmin;
+  glm::vec3 rd;
+  float     tmax;
+  glm::vec3 hit_pos;
+  float     thit;
+  s32       node;
+  u32       cursor;
+  s32       elem;
+  float     domain_tmax;
+};
+
+// per pixel hit record of the temporal raycaster (see temporal.glsl)
+struct temporal_hit
+{
+  glm::vec3 pos;
+  s32       elem;
+  glm::vec3 ref;
+  u32       age;
+};
+
+
 template<typename T>
 T clamp(T v, T min, T max) {
   if (v < min) {
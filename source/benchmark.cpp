@@ -0,0 +1,175 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <chrono>
+#include <cmath>
+
+#include "monomial.cpp"
+
+
+// times nodal against monomial (Horner) basis evaluation for each supported
+// order on synthetic curved elements
+
+void benchmark_basis();
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+dg_solution synthetic_solution(u32 p, u32 nelem)
+{
+  // a row of warped unit cubes (q = p) carrying a smooth conservative state
+
+  dg_solution solution(elem_type::hex, p, p, nelem, 1, 1.4f);
+  render_field& field = solution.add_field("state", state_type::conservative);
+
+  const float pi = glm::pi<float>();
+  u32 qp1        = solution.q + 1;
+
+  for (u32 e = 0; e < nelem; ++e)
+  {
+    for (u32 iz = 0; iz < qp1; ++iz)
+    {
+      for (u32 iy = 0; iy < qp1; ++iy)
+      {
+        for (u32 ix = 0; ix < qp1; ++ix)
+        {
+          float x = float(e) + float(ix) / float(solution.q);
+          float y = float(iy) / float(solution.q);
+          float z = float(iz) / float(solution.q);
+
+          float* node = solution.node(e, qp1 * qp1 * iz + qp1 * iy + ix);
+          node[0]     = x + 0.05f * sinf(pi * y);
+          node[1]     = y + 0.05f * sinf(pi * z);
+          node[2]     = z + 0.05f * sinf(pi * x);
+        }
+      }
+    }
+  }
+
+  for (u32 e = 0; e < nelem; ++e)
+  {
+    for (u32 r = 0; r < 5; ++r)
+    {
+      for (u32 i = 0; i < solution.nbfp; ++i)
+      {
+        field.state[solution.nbfp * (5 * e + r) + i] =
+        1.f + 0.1f * float(r) + 0.05f * sinf(0.37f * float(i + e));
+      }
+    }
+  }
+
+  return solution;
+}
+
+
+double time_basis_evaluation(compute_pipeline& comp, u32 nelem, u32 nrep)
+{
+  u32 ngroups = (nelem + (128 - 1)) / 128;
+
+  comp.run(ngroups, 1, 1);  // warm up
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < nrep; ++i)
+  {
+    comp.run(ngroups, 1, 1);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double, std::milli> duration = t1 - t0;
+  return duration.count() / double(nrep);
+}
+
+
+void benchmark_basis()
+{
+  const u32 nelem = 4096;
+  const u32 nrep  = 10;
+
+  printf("--- basis evaluation benchmark ---\n");
+  printf("  %u elements, 64 samples per element, mean of %u runs\n\n", nelem,
+         nrep);
+  printf("  order | nodal (ms) | monomial (ms) | speedup | max rel diff\n");
+
+  for (u32 p = 1; p <= max_shader_order; ++p)
+  {
+    dg_solution solution = synthetic_solution(p, nelem);
+    render_field& field  = solution.fields["state"];
+
+    dbuffer<dg_solution> d_geom(1);
+    dbuffer<float> d_nodes(solution.nodes.size());
+    dbuffer<float> d_state(field.state.size());
+    dbuffer<float> d_result(nelem);
+
+    dmalloc(d_geom);
+    dmalloc(d_nodes);
+    dmalloc(d_state);
+    dmalloc(d_result);
+
+    memcpy_htod(d_geom, &solution);
+    memcpy_htod(d_nodes, solution.nodes.data());
+    memcpy_htod(d_state, field.state.data());
+
+    std::vector<float> nodal_result(nelem);
+    std::vector<float> monomial_result(nelem);
+
+    double nodal_ms, monomial_ms;
+
+    {
+      specialization_constants constants(solution, output_type::mach, false);
+      compute_pipeline comp(SHADER_DIR "basis_benchmark.spv", 4, constants);
+
+      comp.dset.update(d_geom,   0);
+      comp.dset.update(d_nodes,  1);
+      comp.dset.update(d_state,  2);
+      comp.dset.update(d_result, 3);
+
+      nodal_ms = time_basis_evaluation(comp, nelem, nrep);
+      memcpy_dtoh(nodal_result.data(), d_result);
+    }
+
+    {
+      specialization_constants constants(solution, output_type::mach, true);
+      monomial_transform(d_geom, d_nodes, d_state, solution, constants);
+
+      compute_pipeline comp(SHADER_DIR "basis_benchmark.spv", 4, constants);
+
+      comp.dset.update(d_geom,   0);
+      comp.dset.update(d_nodes,  1);
+      comp.dset.update(d_state,  2);
+      comp.dset.update(d_result, 3);
+
+      monomial_ms = time_basis_evaluation(comp, nelem, nrep);
+      memcpy_dtoh(monomial_result.data(), d_result);
+    }
+
+    float max_rel_diff = 0.f;
+    for (u32 e = 0; e < nelem; ++e)
+    {
+      float diff  = fabsf(nodal_result[e] - monomial_result[e]);
+      float scale = fmaxf(fabsf(nodal_result[e]), 1.f);
+      if (diff / scale > max_rel_diff) max_rel_diff = diff / scale;
+    }
+
+    printf("  %5u | %10.3f | %13.3f | %7.2f | %.2e\n", p, nodal_ms,
+           monomial_ms, nodal_ms / monomial_ms, max_rel_diff);
+  }
+
+  printf("\n");
+}
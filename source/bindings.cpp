@@ -62,6 +62,21 @@ void key_callback(GLFWwindow* win, int key, int scancode, int action, int mods)
     RAYCAST_MODE = raycast_mode::slice;
   if (key == GLFW_KEY_I && action == GLFW_PRESS)
     RAYCAST_MODE = raycast_mode::isosurface;
+  if (key == GLFW_KEY_B && action == GLFW_PRESS)
+    RAYCAST_MODE = raycast_mode::boundary;
+  if (key == GLFW_KEY_V && action == GLFW_PRESS)
+    RAYCAST_MODE = raycast_mode::volume;
+  if (key == GLFW_KEY_J && action == GLFW_PRESS)
+    RAYCAST_MODE = raycast_mode::slices;
+
+  if (key == GLFW_KEY_O && action == GLFW_PRESS)
+    slice_orthogonal = !slice_orthogonal;
+
+  if (key == GLFW_KEY_E && action == GLFW_PRESS)
+    iso_mesh_exact_when_still = !iso_mesh_exact_when_still;
+
+  if (key == GLFW_KEY_H && action == GLFW_PRESS)
+    clip_at_slice = !clip_at_slice;
 
   if (key == GLFW_KEY_C && action == GLFW_PRESS)
     modify_slice = true;
@@ -81,7 +96,36 @@ void key_callback(GLFWwindow* win, int key, int scancode, int action, int mods)
   if (key == GLFW_KEY_U && action == GLFW_PRESS)
     render_ui = !render_ui;
 
-  if (key == GLFW_KEY_R && (action == GLFW_PRESS || action == GLFW_REPEAT))
+  if (key == GLFW_KEY_K && action == GLFW_PRESS)
+  {
+    u32 ci = 0;
+    while (ci < ncolormaps && colormap_cycle[ci] != colormap)
+      ++ci;
+    colormap = colormap_cycle[(ci + (shift ? ncolormaps - 1 : 1)) % ncolormaps];
+    colormap_changed = true;
+  }
+
+  if (key == GLFW_KEY_LEFT_BRACKET &&
+      (action == GLFW_PRESS || action == GLFW_REPEAT))
+    isovalue_shift -= 1;
+  if (key == GLFW_KEY_RIGHT_BRACKET &&
+      (action == GLFW_PRESS || action == GLFW_REPEAT))
+    isovalue_shift += 1;
+
+  if (key == GLFW_KEY_P && action == GLFW_PRESS)
+  {
+    raycast_path& path = RAYCAST_PATH[(int)RAYCAST_MODE];
+    do
+    {
+      path = (raycast_path)(((int)path + 1) % nraycast_paths);
+    }
+    while (!raycast_path_supported[(int)RAYCAST_MODE][(int)path]);
+  }
+
+  // the frame governor owns the render scale while a target is set
+
+  if (key == GLFW_KEY_R && (action == GLFW_PRESS || action == GLFW_REPEAT) &&
+      !render_scale_locked)
   {
     if (shift)
     {
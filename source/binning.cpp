@@ -0,0 +1,220 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// screen tile element binning, element bounding boxes are projected to the
+// screen once per frame into per tile candidate lists, sorted front to back,
+// which the binned raycast intersects in place of k-d traversal (see
+// shaders/binning.glsl)
+
+const u32 bin_width        = 64;  // must match shaders/binning.glsl
+const u32 bin_tile_entries = 32;  // average list capacity per tile
+
+struct binning_data
+{
+  u32 ntile;
+  u32 nelem;
+
+  dbuffer<u32>        d_tile_counts;
+  dbuffer<u32>        d_tile_offsets;
+  dbuffer<u32>        d_tile_fill;
+  dbuffer<u32>        d_tile_near;
+  dbuffer<u32>        d_tile_far;
+  dbuffer<s32>        d_tile_elems;
+  dbuffer<glm::ivec4> d_elem_rects;
+  dbuffer<glm::vec2>  d_elem_depth;
+
+  descriptor_set_layout layout;
+  descriptor_set        dset;
+
+  // ---
+
+  binning_data(u32 nelem_);
+
+  // tile buffers are sized by the render image, call after swap chain changes
+  void resize(VkExtent2D extent);
+};
+
+void make_binning_passes(std::unordered_map<std::string, compute_pass>& passes,
+                         const std::vector<descriptor_set_layout*>& layouts,
+                         const specialization_constants& constants);
+
+void record_binned_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, binning_data& bins, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+binning_data::binning_data(u32 nelem_) :
+ntile(0),
+nelem(nelem_),
+d_tile_counts(),
+d_tile_offsets(),
+d_tile_fill(),
+d_tile_near(),
+d_tile_far(),
+d_tile_elems(),
+d_elem_rects(nelem_),
+d_elem_depth(nelem_),
+layout(8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+dset(&layout)
+{
+  dmalloc(d_elem_rects);
+  dmalloc(d_elem_depth);
+}
+
+void binning_data::resize(VkExtent2D extent)
+{
+  ntile = ((extent.width  + raycast_tile_size - 1) / raycast_tile_size) *
+          ((extent.height + raycast_tile_size - 1) / raycast_tile_size);
+
+  d_tile_counts  = dbuffer<u32>(ntile);
+  d_tile_offsets = dbuffer<u32>(ntile);
+  d_tile_fill    = dbuffer<u32>(ntile);
+  d_tile_near    = dbuffer<u32>(ntile);
+  d_tile_far     = dbuffer<u32>(ntile);
+  d_tile_elems   = dbuffer<s32>(bin_tile_entries * ntile);
+
+  dmalloc(d_tile_counts);
+  dmalloc(d_tile_offsets);
+  dmalloc(d_tile_fill);
+  dmalloc(d_tile_near);
+  dmalloc(d_tile_far);
+  dmalloc(d_tile_elems);
+
+  dset.update(d_tile_counts,  0);
+  dset.update(d_tile_offsets, 1);
+  dset.update(d_tile_fill,    2);
+  dset.update(d_tile_near,    3);
+  dset.update(d_tile_far,     4);
+  dset.update(d_tile_elems,   5);
+  dset.update(d_elem_rects,   6);
+  dset.update(d_elem_depth,   7);
+}
+
+void make_binning_passes(std::unordered_map<std::string, compute_pass>& passes,
+                         const std::vector<descriptor_set_layout*>& layouts,
+                         const specialization_constants& constants)
+{
+  std::vector<std::string> names = {
+  "bin_count",
+  "bin_scan",
+  "bin_fill",
+  "bin_sort",
+  };
+
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    if (!raycast_path_supported[mi][(int)raycast_path::binned])
+      continue;
+
+    names.push_back(std::string("raycast_") + raycast_mode_names[mi] +
+                    "_binned");
+  }
+
+  for (const std::string& name : names)
+  {
+    passes.emplace(name, compute_pass(SHADER_DIR + name + ".spv", layouts, 0,
+                                      constants));
+  }
+}
+
+void record_binned_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, binning_data& bins, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const compute_pass& count   = passes.at("bin_count");
+  const compute_pass& scan    = passes.at("bin_scan");
+  const compute_pass& fill    = passes.at("bin_fill");
+  const compute_pass& sort    = passes.at("bin_sort");
+  const compute_pass& raycast = passes.at(mode_name + "_binned");
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  bins.dset.dset,
+  };
+
+  u32 elem_groups = (bins.nelem + bin_width - 1) / bin_width;
+
+  begin_compute_raycast_command_buffer(command_buffer);
+
+  timer.start(command_buffer);
+
+  // reset the tile counters and depth bounds (near starts at FLT_MAX)
+
+  vkCmdFillBuffer(*command_buffer, bins.d_tile_counts.buffer, 0, VK_WHOLE_SIZE,
+                  0);
+  vkCmdFillBuffer(*command_buffer, bins.d_tile_fill.buffer, 0, VK_WHOLE_SIZE,
+                  0);
+  vkCmdFillBuffer(*command_buffer, bins.d_tile_near.buffer, 0, VK_WHOLE_SIZE,
+                  0x7f7fffff);
+  vkCmdFillBuffer(*command_buffer, bins.d_tile_far.buffer, 0, VK_WHOLE_SIZE,
+                  0);
+
+  memory_barrier(command_buffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                 VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                 VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+  // bin the elements
+
+  count.record(command_buffer, dsets, nullptr, elem_groups, 1, 1);
+  compute_barrier(command_buffer);
+  scan.record(command_buffer, dsets, nullptr, 1, 1, 1);
+  compute_barrier(command_buffer);
+  fill.record(command_buffer, dsets, nullptr, elem_groups, 1, 1);
+  compute_barrier(command_buffer);
+
+  // order the lists front to back, one workgroup per tile
+
+  VkExtent2D extent = scaled_render_extent();
+  sort.record(command_buffer, dsets, nullptr,
+              (extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+              (extent.height + raycast_tile_size - 1) / raycast_tile_size, 1);
+  compute_barrier(command_buffer);
+
+  // trace the tiles against their lists
+  raycast.record(command_buffer, dsets, nullptr,
+                 (extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+                 (extent.height + raycast_tile_size - 1) / raycast_tile_size,
+                 1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
+}
@@ -0,0 +1,123 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "dg_solution.cpp"
+
+
+// Exterior faces of a conforming hex mesh. Faces are numbered
+// 6 * elem + 2 * axis + side, the face where reference coordinate "axis" is
+// "side" (0 or 1). Two elements share a face when its four corner nodes
+// coincide, faces without a partner are on the domain boundary.
+
+std::vector<s32> find_boundary_faces(dg_solution& solution);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+std::vector<s32> find_boundary_faces(dg_solution& solution)
+{
+  u32 q   = solution.q;
+  u32 qp1 = q + 1;
+
+  // corners are matched on a grid relative to the domain size so that shared
+  // corners written with slightly different rounding by the two elements
+  // still produce the same key
+
+  glm::vec3 lo(+FLT_MAX), hi(-FLT_MAX);
+  for (u32 e = 0; e < solution.nelem; ++e)
+  {
+    for (u32 k = 0; k < 8; ++k)
+    {
+      u32 i = (k % 2) * q;
+      u32 j = ((k / 2) % 2) * q;
+      u32 l = (k / 4) * q;
+
+      float*    node = solution.node(e, qp1 * (qp1 * l + j) + i);
+      glm::vec3 pos(node[0], node[1], node[2]);
+      lo = glm::min(lo, pos);
+      hi = glm::max(hi, pos);
+    }
+  }
+
+  glm::vec3 span = hi - lo;
+  float     tol  = 1e-5f * std::max(span.x, std::max(span.y, span.z));
+  if (!(tol > 0.f))
+    tol = 1.f;
+
+  // unmatched faces keyed on their sorted quantized corner positions
+
+  typedef std::array<s64, 12> face_key;
+  typedef std::array<s64, 3>  corner_key;
+  std::map<face_key, s32> open;
+
+  for (u32 e = 0; e < solution.nelem; ++e)
+  {
+    for (u32 f = 0; f < 6; ++f)
+    {
+      u32 a = f / 2;
+      u32 b = (a + 1) % 3;
+      u32 c = (a + 2) % 3;
+
+      std::array<corner_key, 4> corners;
+      for (u32 k = 0; k < 4; ++k)
+      {
+        u32 ijk[3];
+        ijk[a] = (f % 2) * q;
+        ijk[b] = (k % 2) * q;
+        ijk[c] = (k / 2) * q;
+
+        float* node = solution.node(e, qp1 * (qp1 * ijk[2] + ijk[1]) + ijk[0]);
+        for (u32 d = 0; d < 3; ++d)
+          corners[k][d] = (s64)std::llround((node[d] - lo[d]) / tol);
+      }
+
+      std::sort(corners.begin(), corners.end());
+
+      face_key key;
+      for (u32 k = 0; k < 4; ++k)
+      {
+        key[3 * k + 0] = corners[k][0];
+        key[3 * k + 1] = corners[k][1];
+        key[3 * k + 2] = corners[k][2];
+      }
+
+      auto match = open.find(key);
+      if (match != open.end())
+        open.erase(match);
+      else
+        open.emplace(key, (s32)(6 * e + f));
+    }
+  }
+
+  std::vector<s32> faces;
+  faces.reserve(open.size());
+  for (const auto& pair : open)
+    faces.push_back(pair.second);
+  std::sort(faces.begin(), faces.end());
+
+  return faces;
+}
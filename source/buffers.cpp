@@ -32,6 +32,7 @@ VkFormat find_supported_format(const VkFormat* candidates, u32 ncandidates,
                                VkFormatFeatureFlags features);
 
 VkFormat find_depth_format();
+VkImageAspectFlags depth_aspect(VkFormat depth_format);
 
 u32 find_memory_type(u32 type_filter, VkMemoryPropertyFlags properties);
 
@@ -46,6 +47,43 @@ VkImageView make_image_view(VkImage image, VkFormat format,
                             VkImageAspectFlags aspect_flags);
 
 
+// sampled lookup table image, a device local image with its view and a
+// linearly filtering, edge clamping sampler, filled from the host
+
+struct texture
+{
+  u32      width;
+  u32      height;
+  VkFormat format;
+
+  VkImage        image;
+  VkDeviceMemory memory;
+  VkImageView    view;
+  VkSampler      sampler;
+
+  // ---
+
+  texture();
+  texture(u32 width_, u32 height_, VkFormat format_);
+
+  texture(const texture& oth)            = delete;
+  texture& operator=(const texture& oth) = delete;
+
+  texture(texture&& oth) noexcept;
+  texture& operator=(texture&& oth) noexcept;
+
+  ~texture();
+
+  // ---
+
+  // replaces the contents and leaves the image ready for sampling, the image
+  // must not be in use by the device
+  void upload(const void* texels, VkDeviceSize size);
+
+  void clean();
+};
+
+
 // buffer helper functions
 
 void make_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
@@ -134,6 +172,14 @@ VkFormat find_depth_format()
   return depth_format;
 }
 
+VkImageAspectFlags depth_aspect(VkFormat depth_format)
+{
+  if (depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+      depth_format == VK_FORMAT_D24_UNORM_S8_UINT)
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+  return VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
 u32 find_memory_type(u32 type_filter, VkMemoryPropertyFlags properties)
 {
   VkPhysicalDeviceMemoryProperties mem_properties;
@@ -206,6 +252,186 @@ VkImageView make_image_view(VkImage image, VkFormat format,
   return image_view;
 }
 
+/* ------- */
+/* texture ------------------------------------------------------------------ */
+/* ------- */
+
+texture::texture() :
+width(0),
+height(0),
+format(VK_FORMAT_UNDEFINED),
+image(VK_NULL_HANDLE),
+memory(VK_NULL_HANDLE),
+view(VK_NULL_HANDLE),
+sampler(VK_NULL_HANDLE)
+{}
+
+texture::texture(u32 width_, u32 height_, VkFormat format_) :
+width(width_),
+height(height_),
+format(format_),
+image(VK_NULL_HANDLE),
+memory(VK_NULL_HANDLE),
+view(VK_NULL_HANDLE),
+sampler(VK_NULL_HANDLE)
+{
+  make_image(width, height, format, VK_IMAGE_TILING_OPTIMAL,
+             VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+  view = make_image_view(image, format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+  VkSamplerCreateInfo cinf{};
+  cinf.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  cinf.magFilter    = VK_FILTER_LINEAR;
+  cinf.minFilter    = VK_FILTER_LINEAR;
+  cinf.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  cinf.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  cinf.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  cinf.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  cinf.minLod       = 0.f;
+  cinf.maxLod       = 0.f;
+  VK_CHECK(vkCreateSampler(device, &cinf, nullptr, &sampler),
+           "sampler creation failed!");
+}
+
+texture::texture(texture&& oth) noexcept :
+width(oth.width),
+height(oth.height),
+format(oth.format),
+image(oth.image),
+memory(oth.memory),
+view(oth.view),
+sampler(oth.sampler)
+{
+  oth.image   = VK_NULL_HANDLE;
+  oth.memory  = VK_NULL_HANDLE;
+  oth.view    = VK_NULL_HANDLE;
+  oth.sampler = VK_NULL_HANDLE;
+}
+
+texture& texture::operator=(texture&& oth) noexcept
+{
+  clean();
+
+  width   = oth.width;
+  height  = oth.height;
+  format  = oth.format;
+  image   = oth.image;
+  memory  = oth.memory;
+  view    = oth.view;
+  sampler = oth.sampler;
+
+  oth.image   = VK_NULL_HANDLE;
+  oth.memory  = VK_NULL_HANDLE;
+  oth.view    = VK_NULL_HANDLE;
+  oth.sampler = VK_NULL_HANDLE;
+
+  return *this;
+}
+
+texture::~texture()
+{
+  clean();
+}
+
+void texture::clean()
+{
+  vkDestroySampler(device, sampler, nullptr);
+  vkDestroyImageView(device, view, nullptr);
+  vkDestroyImage(device, image, nullptr);
+  vkFreeMemory(device, memory, nullptr);
+}
+
+void texture::upload(const void* texels, VkDeviceSize size)
+{
+  VkBuffer staging_buffer              = VK_NULL_HANDLE;
+  VkDeviceMemory staging_buffer_memory = VK_NULL_HANDLE;
+
+  make_buffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+              staging_buffer, staging_buffer_memory);
+
+  void* data;
+  vkMapMemory(device, staging_buffer_memory, 0, size, 0, &data);
+  memcpy(data, texels, (size_t)size);
+  vkUnmapMemory(device, staging_buffer_memory);
+
+  // recorded on the graphics queue so the sampling queues own the image
+
+  VkCommandBuffer command_buffer;
+  VkCommandBufferAllocateInfo alloc_info{};
+  alloc_info.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  alloc_info.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  alloc_info.commandPool = graphics_command_pool;
+  alloc_info.commandBufferCount = 1;
+  vkAllocateCommandBuffers(device, &alloc_info, &command_buffer);
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(command_buffer, &begin_info);
+
+  VkImageMemoryBarrier2 barrier{};
+  barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+  barrier.srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+  barrier.srcAccessMask       = 0;
+  barrier.dstStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+  barrier.dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+  barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image               = image;
+  barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel   = 0;
+  barrier.subresourceRange.levelCount     = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount     = 1;
+
+  VkDependencyInfo dependency{};
+  dependency.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependency.imageMemoryBarrierCount = 1;
+  dependency.pImageMemoryBarriers    = &barrier;
+  vkCmdPipelineBarrier2(command_buffer, &dependency);
+
+  VkBufferImageCopy region{};
+  region.bufferOffset                    = 0;
+  region.bufferRowLength                 = 0;
+  region.bufferImageHeight               = 0;
+  region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel       = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount     = 1;
+  region.imageOffset                     = {0, 0, 0};
+  region.imageExtent                     = {width, height, 1};
+  vkCmdCopyBufferToImage(command_buffer, staging_buffer, image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+  barrier.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+  barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+  barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+  barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+  barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  vkCmdPipelineBarrier2(command_buffer, &dependency);
+
+  vkEndCommandBuffer(command_buffer);
+
+  VkSubmitInfo submit_info{};
+  submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers    = &command_buffer;
+  vkQueueSubmit(graphics_queue, 1, &submit_info, VK_NULL_HANDLE);
+  vkQueueWaitIdle(graphics_queue);
+
+  vkFreeCommandBuffers(device, graphics_command_pool, 1, &command_buffer);
+
+  vkDestroyBuffer(device, staging_buffer, nullptr);
+  vkFreeMemory(device, staging_buffer_memory, nullptr);
+}
+
 void make_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
                  VkMemoryPropertyFlags properties, VkBuffer& buffer,
                  VkDeviceMemory& buffer_memory)
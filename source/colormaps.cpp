@@ -1324,3 +1324,13 @@ struct colormap_type
   usize map_size;
   float* map;
 };
+
+// colormaps in the order they are cycled through at runtime
+const u32 ncolormaps = 5;
+float* const colormap_cycle[ncolormaps] = {
+colormap_cividis,
+colormap_jet,
+colormap_coolwarm,
+colormap_viridis,
+colormap_plasma,
+};
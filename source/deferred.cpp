@@ -0,0 +1,157 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// deferred raycasting, a trace pass fills a per pixel visibility buffer and a
+// shade pass colors the image from it (see shaders/visibility.glsl). The
+// trace pass only re-runs when the view or the mode changes.
+
+struct visibility_data
+{
+  u32 npixel;
+
+  // what the visibility buffer was traced with, mode -1 if it is invalid
+  s32             mode;
+  scene_transform transform;
+
+  dbuffer<glm::vec4> d_hits;
+  dbuffer<s32>       d_elems;
+
+  descriptor_set_layout layout;
+  descriptor_set        dset;
+
+  // ---
+
+  visibility_data();
+
+  // buffers are sized by the render image, call after swap chain changes
+  void resize(VkExtent2D extent);
+};
+
+void make_deferred_passes(std::unordered_map<std::string, compute_pass>& passes,
+                          const std::vector<descriptor_set_layout*>& layouts,
+                          const specialization_constants& constants);
+
+void record_deferred_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, visibility_data& vdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+visibility_data::visibility_data() :
+npixel(0),
+mode(-1),
+transform(),
+d_hits(),
+d_elems(),
+layout(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+dset(&layout)
+{}
+
+void visibility_data::resize(VkExtent2D extent)
+{
+  npixel = extent.width * extent.height;
+  mode   = -1;
+
+  d_hits  = dbuffer<glm::vec4>(npixel);
+  d_elems = dbuffer<s32>(npixel);
+
+  dmalloc(d_hits);
+  dmalloc(d_elems);
+
+  dset.update(d_hits,  0);
+  dset.update(d_elems, 1);
+}
+
+void make_deferred_passes(std::unordered_map<std::string, compute_pass>& passes,
+                          const std::vector<descriptor_set_layout*>& layouts,
+                          const specialization_constants& constants)
+{
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    if (!raycast_path_supported[mi][(int)raycast_path::deferred])
+      continue;
+
+    std::string mode = std::string("raycast_") + raycast_mode_names[mi];
+    for (const char* pass : {"_deferred_trace", "_deferred_shade"})
+    {
+      passes.emplace(mode + pass, compute_pass(SHADER_DIR + mode + pass +
+                                               ".spv", layouts, 0, constants));
+    }
+  }
+}
+
+void record_deferred_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, visibility_data& vdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const compute_pass& trace = passes.at(mode_name + "_deferred_trace");
+  const compute_pass& shade = passes.at(mode_name + "_deferred_shade");
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  vdata.dset.dset,
+  };
+
+  bool retrace =
+  vdata.mode != (s32)RAYCAST_MODE ||
+  memcmp(&vdata.transform, &scene_ubo.host_data, sizeof(scene_transform)) != 0;
+
+  VkExtent2D extent = scaled_render_extent();
+  u32 tiles_x = (extent.width  + raycast_tile_size - 1) / raycast_tile_size;
+  u32 tiles_y = (extent.height + raycast_tile_size - 1) / raycast_tile_size;
+
+  begin_compute_raycast_command_buffer(command_buffer);
+
+  timer.start(command_buffer);
+
+  if (retrace)
+  {
+    trace.record(command_buffer, dsets, nullptr, tiles_x, tiles_y, 1);
+    compute_barrier(command_buffer);
+
+    vdata.mode      = (s32)RAYCAST_MODE;
+    vdata.transform = scene_ubo.host_data;
+  }
+
+  shade.record(command_buffer, dsets, nullptr, tiles_x, tiles_y, 1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
+}
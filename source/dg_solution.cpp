@@ -86,6 +86,11 @@ struct dg_solution
 };
 
 
+// highest order the shader basis library evaluates (max_order in basis.glsl)
+
+const u32 max_shader_order = 8;
+
+
 // i/o
 
 dg_solution read_dg_solution(const char* fname);
@@ -235,6 +240,12 @@ dg_solution read_dg_solution(const char* fname)
   iochk(fread(&p, sizeof(p), 1, fstr), 1);
   iochk(fread(&q, sizeof(q), 1, fstr), 1);
 
+  if (p > max_shader_order || q > max_shader_order)
+  {
+    TERMINATE("solution order %d / geometry order %d exceeds the supported "
+              "maximum of %d!", (int)p, (int)q, (int)max_shader_order);
+  }
+
   // boundary types
   for (usize i = 0; i < 6; ++i)
   {
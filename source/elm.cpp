@@ -15,12 +15,31 @@
 /* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
 
 
+#include "benchmark.cpp"
+#include "boundary_faces.cpp"
 #include "init.cpp"
+#include "monomial.cpp"
 #include "optparse.cpp"
 #include "render_loop.cpp"
 #include "state.cpp"
 
 
+// Reads a comma separated list of at most max floats, false if malformed.
+bool parse_float_list(const std::string& list, u32 max, float* vals, u32& n)
+{
+  n = 0;
+  for (const char* c = list.c_str(); *c != '\0';)
+  {
+    char* end;
+    float val = strtof(c, &end);
+    if (end == c || n == max)
+      return false;
+    vals[n++] = val;
+    c = *end == ',' ? end + 1 : end;
+  }
+  return true;
+}
+
 int main(int argc, char** argv)
 {
   /* input parsing */
@@ -30,14 +49,34 @@ int main(int argc, char** argv)
   std::string output_string = "mach";
   std::string cmap_string   = "jet";
   bool init_only            = false;
-
-  const usize optc     = 5;
+  bool monomial             = false;
+  bool bench_basis          = false;
+  bool bench_paths          = false;
+  double target_ms          = 0.;
+  std::string iso_string    = "0.075";
+  u32 slice_count           = nslices;
+  std::string clip_string   = "";
+  std::string box_string    = "";
+
+  const usize optc     = 13;
   option optlist[optc] = {
   mkopt("ifile", "input file prefix", &ifile),
   mkopt("features", "prints vulkan implementation features", &print_vkfeatures),
   mkopt("cmap", "colormap selection", &cmap_string),
   mkopt("output", "rendering output", &output_string),
   mkopt("initonly", "do not render, only initialize", &init_only),
+  mkopt("monomial", "evaluate in tensor monomial (Horner) form", &monomial),
+  mkopt("benchbasis", "benchmark nodal vs monomial evaluation and exit",
+        &bench_basis),
+  mkopt("bench", "benchmark every raycast path and exit",
+        &bench_paths),
+  mkopt("target_ms", "raycast time target, adapts resolution and budgets",
+        &target_ms),
+  mkopt("iso", "comma separated isovalues (at most 8)", &iso_string),
+  mkopt("slices", "planes in the slice set stack (at most 20)", &slice_count),
+  mkopt("clip", "clip planes keeping n.p <= d as nx,ny,nz,d,... (at most 3)",
+        &clip_string),
+  mkopt("clipbox", "clip box as lx,ly,lz,hx,hy,hz", &box_string),
   };
 
   bool help = false;
@@ -48,6 +87,68 @@ int main(int argc, char** argv)
   colormap      = cmap_map.at(cmap_string);
   render_output = output_map.at(output_string);
 
+  if (!parse_float_list(iso_string, max_isovalues, isovalues, niso))
+  {
+    printf("bad isovalue list \"%s\" (at most %d numbers)\n",
+           iso_string.c_str(), (int)max_isovalues);
+    return 1;
+  }
+
+  // one clip plane is left free for clipping at the slice frame
+
+  float clip_vals[4 * max_clip_planes];
+  u32   nclip_vals;
+  if (!parse_float_list(clip_string, 4 * (max_clip_planes - 1), clip_vals,
+                        nclip_vals) || nclip_vals % 4 != 0)
+  {
+    printf("bad clip plane list \"%s\" (at most %d planes of 4 numbers)\n",
+           clip_string.c_str(), (int)(max_clip_planes - 1));
+    return 1;
+  }
+  nclip_planes = nclip_vals / 4;
+  for (u32 i = 0; i < nclip_planes; ++i)
+  {
+    glm::vec3 n(clip_vals[4 * i], clip_vals[4 * i + 1], clip_vals[4 * i + 2]);
+    float     len = glm::length(n);
+    if (len == 0.f)
+    {
+      printf("bad clip plane %d (zero normal)\n", (int)i);
+      return 1;
+    }
+    clip_planes[i] = glm::vec4(n / len, clip_vals[4 * i + 3] / len);
+  }
+
+  float box_vals[6];
+  u32   nbox_vals;
+  if (!parse_float_list(box_string, 6, box_vals, nbox_vals) ||
+      (nbox_vals != 0 && nbox_vals != 6))
+  {
+    printf("bad clip box \"%s\" (6 numbers)\n", box_string.c_str());
+    return 1;
+  }
+  clip_box_on = nbox_vals == 6;
+  if (clip_box_on)
+  {
+    clip_box.l = glm::vec3(box_vals[0], box_vals[1], box_vals[2]);
+    clip_box.h = glm::vec3(box_vals[3], box_vals[4], box_vals[5]);
+  }
+
+  if (slice_count < 1 || slice_count > max_slices)
+  {
+    printf("bad slice count %d (1 to %d)\n", (int)slice_count,
+           (int)max_slices);
+    return 1;
+  }
+  nslices = slice_count;
+
+  if (bench_basis)
+  {
+    vkinit(print_vkfeatures);
+    benchmark_basis();
+    clean_global_resources();
+    return 0;
+  }
+
   /* read input file */
 
   ifile += ".dg";
@@ -85,6 +186,14 @@ int main(int argc, char** argv)
     }
   }
 
+  // the clip region was given in the input coordinates
+
+  for (u32 i = 0; i < nclip_planes; ++i)
+    clip_planes[i].w -= glm::dot(glm::vec3(clip_planes[i]), center);
+
+  clip_box.l -= center;
+  clip_box.h -= center;
+
   auto c1 = std::chrono::steady_clock::now();
 
   std::chrono::duration<double, std::milli> centering_duration = c1 - c0;
@@ -104,7 +213,12 @@ int main(int argc, char** argv)
 
   {
 
-    compute_pipeline comp_metadata(SHADER_DIR "metadata.spv", 7);
+    // shader variants are specialized on the solution orders and output
+
+    specialization_constants constants(rendering_data, render_output,
+                                       monomial);
+
+    compute_pipeline comp_metadata(SHADER_DIR "metadata.spv", 9, constants);
 
     raycast_data rcdata;
 
@@ -122,16 +236,27 @@ int main(int argc, char** argv)
     memcpy_htod(rcdata.d_nodes, rendering_data.nodes.data());
     memcpy_htod(rcdata.d_state, current_field.state.data());
 
+    if (monomial)
+    {
+      printf("--- transforming to monomial form ---\n");
+      auto m0 = std::chrono::steady_clock::now();
+
+      monomial_transform(rcdata.d_geom, rcdata.d_nodes, rcdata.d_state,
+                         rendering_data, constants);
+
+      auto m1 = std::chrono::steady_clock::now();
+      std::chrono::duration<double, std::milli> monomial_duration = m1 - m0;
+      printf("  done, finished in %.1f ms\n\n", monomial_duration.count());
+    }
+
     /* transfer rendering options */
 
-    rcdata.d_colormap = dbuffer<float>(256 * 3);
-    rcdata.d_output   = dbuffer<output_type>(1);
+    rcdata.d_output = dbuffer<output_type>(1);
 
-    dmalloc(rcdata.d_colormap);
     dmalloc(rcdata.d_output);
 
-    memcpy_htod(rcdata.d_colormap, colormap);
     memcpy_htod(rcdata.d_output, &render_output);
+    rcdata.set_colormap(colormap);
 
     /* pre-compute rendering metadata */
 
@@ -142,11 +267,19 @@ int main(int argc, char** argv)
     rcdata.d_output_bounds        = dbuffer<glm::vec2>(rendering_data.nelem);
     rcdata.d_domain_bbox          = dbuffer<aabb>(1);
     rcdata.d_domain_output_bounds = dbuffer<glm::vec2>(1);
+    rcdata.d_elem_maps = dbuffer<elem_inverse_map>(rendering_data.nelem);
+    rcdata.d_elem_warm = dbuffer<glm::vec4>(warm_table_size *
+                                             rendering_data.nelem);
+    rcdata.d_subcell_bounds = dbuffer<glm::vec2>(subcell_bounds_size *
+                                                 rendering_data.nelem);
 
     dmalloc(rcdata.d_bboxes);
     dmalloc(rcdata.d_output_bounds);
     dmalloc(rcdata.d_domain_bbox);
     dmalloc(rcdata.d_domain_output_bounds);
+    dmalloc(rcdata.d_elem_maps);
+    dmalloc(rcdata.d_elem_warm);
+    dmalloc(rcdata.d_subcell_bounds);
 
     comp_metadata.dset.update(rcdata.d_geom,          0);
     comp_metadata.dset.update(rcdata.d_nodes,         1);
@@ -154,6 +287,9 @@ int main(int argc, char** argv)
     comp_metadata.dset.update(rcdata.d_output,        3);
     comp_metadata.dset.update(rcdata.d_bboxes,        4);
     comp_metadata.dset.update(rcdata.d_output_bounds, 5);
+    comp_metadata.dset.update(rcdata.d_elem_maps,     6);
+    comp_metadata.dset.update(rcdata.d_elem_warm,     7);
+    comp_metadata.dset.update(rcdata.d_subcell_bounds, 8);
     comp_metadata.run((rendering_data.nelem + (128 - 1)) / 128, 1, 1);
 
     // augment metadata computation to avoid using gpu atomics for portability
@@ -181,9 +317,19 @@ int main(int argc, char** argv)
 
     memcpy_htod(rcdata.d_domain_bbox, &rcmetadata.domain_bbox);
     memcpy_htod(rcdata.d_domain_output_bounds, &domain_output_bounds);
+    rcmetadata.domain_output_bounds = domain_output_bounds;
 
     delete[] output_bounds;
 
+    std::vector<elem_inverse_map> elem_maps(rendering_data.nelem);
+    memcpy_dtoh(elem_maps.data(), rcdata.d_elem_maps);
+
+    usize naffine = 0;
+    for (usize ei = 0; ei < rendering_data.nelem; ++ei)
+    {
+      if (elem_maps[ei].origin.w != 0.f) ++naffine;
+    }
+
     auto t1 = std::chrono::steady_clock::now();
     std::chrono::duration<double, std::milli> metadata_duration = t1 - t0;
     printf("  done, finished in %.1f ms\n", metadata_duration.count());
@@ -196,6 +342,7 @@ int main(int argc, char** argv)
            rcmetadata.domain_bbox.l.x, rcmetadata.domain_bbox.l.y,
            rcmetadata.domain_bbox.l.z, rcmetadata.domain_bbox.h.x,
            rcmetadata.domain_bbox.h.y, rcmetadata.domain_bbox.h.z);
+    printf("    affine elements: %zu of %u\n", naffine, rendering_data.nelem);
     printf("\n");
 
     /* compute and transfer kd tree */
@@ -240,6 +387,76 @@ int main(int argc, char** argv)
     printf("    mean depth         | %.3f\n", tree_stats.mean_depth);
     printf("    max leaf overlaps  | %zu\n",  tree_stats.max_leaf_overlaps);
     printf("    max depth          | %zu\n",  tree_stats.max_depth);
+    printf("\n");
+
+    /* extract boundary faces and build their k-d tree */
+
+    printf("--- extracting boundary faces ---\n");
+
+    auto t4 = std::chrono::steady_clock::now();
+
+    std::vector<s32> faces = find_boundary_faces(rendering_data);
+
+    rcdata.d_faces       = dbuffer<s32>(faces.size());
+    rcdata.d_face_bboxes = dbuffer<aabb>(faces.size());
+
+    dmalloc(rcdata.d_faces);
+    dmalloc(rcdata.d_face_bboxes);
+
+    memcpy_htod(rcdata.d_faces, faces.data());
+
+    compute_pipeline comp_face_metadata(SHADER_DIR "face_metadata.spv", 5,
+                                        constants);
+    comp_face_metadata.dset.update(rcdata.d_geom,        0);
+    comp_face_metadata.dset.update(rcdata.d_nodes,       1);
+    comp_face_metadata.dset.update(rcdata.d_state,       2);
+    comp_face_metadata.dset.update(rcdata.d_faces,       3);
+    comp_face_metadata.dset.update(rcdata.d_face_bboxes, 4);
+    comp_face_metadata.run((faces.size() + (128 - 1)) / 128, 1, 1);
+
+    render_metadata face_metadata;
+    face_metadata.domain_bbox = rcmetadata.domain_bbox;
+    face_metadata.elem_bboxes = std::vector<aabb>(faces.size());
+    memcpy_dtoh(face_metadata.elem_bboxes.data(), rcdata.d_face_bboxes);
+
+    std::vector<int> face_overlap_list(faces.size());
+    for (usize i = 0; i < faces.size(); ++i)
+    {
+      face_overlap_list[i] = i;
+    }
+
+    kdtree face_tree;
+    face_tree.bbox = face_metadata.domain_bbox;
+    kd_build(face_metadata.domain_bbox, -1, face_overlap_list, 0,
+             face_metadata, face_tree);
+
+    rcdata.d_face_kdnodes       = dbuffer<kdnode>(face_tree.nodes.size());
+    rcdata.d_face_kd_leaf_faces =
+    dbuffer<int>(face_tree.leaf_elements.size());
+
+    dmalloc(rcdata.d_face_kdnodes);
+    dmalloc(rcdata.d_face_kd_leaf_faces);
+
+    memcpy_htod(rcdata.d_face_kdnodes, face_tree.nodes.data());
+    memcpy_htod(rcdata.d_face_kd_leaf_faces, face_tree.leaf_elements.data());
+
+    auto t5 = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::milli> faces_duration = t5 - t4;
+    printf("  done, finished in %.1f ms\n", faces_duration.count());
+
+    kd_tree_stats face_tree_stats;
+    find_tree_stats(0, 1, face_tree, face_tree_stats);
+
+    printf("\n");
+    printf("  boundary faces: %zu of %u\n", faces.size(),
+           6 * rendering_data.nelem);
+    printf("  face k-d tree stats:\n");
+    printf("    nodes              | %zu\n",  face_tree.nodes.size());
+    printf("    leaf nodes         | %zu\n",  face_tree_stats.leaf_count);
+    printf("    mean leaf overlaps | %.3f\n",
+           face_tree_stats.mean_leaf_overlaps);
+    printf("    max depth          | %zu\n",  face_tree_stats.max_depth);
 
     //
 
@@ -247,7 +464,7 @@ int main(int argc, char** argv)
 
     if (!init_only)
     {
-      render_loop(rcdata, rcmetadata);
+      render_loop(rcdata, rcmetadata, constants, bench_paths, target_ms);
     }
 
   }  // ensures dbuffers clear before vulkan deinit
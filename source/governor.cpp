@@ -0,0 +1,124 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include "state.cpp"
+#include "transform.cpp"
+
+
+// frame time governor, trades render resolution and the Newton iteration
+// budgets of the intersection routines for speed to hold a target raycast time
+
+struct frame_budget
+{
+  u32   render_scale;
+  u32   surface_rounds;  // ray march rounds per element (surface)
+  u32   iso_rounds;      // Newton rounds per isosurface trial
+  u32   slice_steps;     // Newton steps per point location (slice)
+  float tol_scale;       // convergence tolerance multiplier
+};
+
+// ordered from full quality down, the first entry matches the fixed budgets
+// used when no target is set
+const u32 nframe_budgets = 6;
+const frame_budget frame_budgets[nframe_budgets] = {
+{1, 50, 10, 3, 1.f},
+{1, 32,  8, 3, 2.f},
+{2, 32,  8, 2, 2.f},
+{2, 16,  6, 2, 4.f},
+{3, 16,  6, 2, 4.f},
+{4,  8,  4, 1, 8.f},
+};
+
+struct frame_governor
+{
+  double target_ms;  // zero disables the governor
+  double filtered_ms;
+  u32    level;
+  u32    settle;     // frames to wait before the next change
+
+  // ---
+
+  frame_governor(double target_ms);
+
+  // feeds the last frame's raycast time, may change the render scale (and
+  // flag the frame buffer for resizing)
+  void update(double frame_ms);
+
+  // writes the current budgets to the scene uniforms
+  void apply(scene_transform& transform) const;
+};
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+frame_governor::frame_governor(double target_ms) :
+target_ms(target_ms),
+filtered_ms(0.),
+level(0),
+settle(0)
+{}
+
+void frame_governor::update(double frame_ms)
+{
+  const double smoothing   = 0.1;
+  const double slow_factor = 1.1;  // over target, drop a level
+  const double fast_factor = 0.6;  // well under target, raise a level
+  const u32    settle_time = 30;   // frames, lets the filter catch up
+
+  if (target_ms <= 0.)
+    return;
+
+  filtered_ms = filtered_ms == 0. ?
+                frame_ms :
+                (1. - smoothing) * filtered_ms + smoothing * frame_ms;
+
+  if (settle > 0)
+  {
+    --settle;
+    return;
+  }
+
+  u32 last = level;
+  if (filtered_ms > slow_factor * target_ms && level < nframe_budgets - 1)
+    ++level;
+  else if (filtered_ms < fast_factor * target_ms && level > 0)
+    --level;
+
+  if (level == last)
+    return;
+
+  settle = settle_time;
+
+  if (render_image_scale != frame_budgets[level].render_scale)
+  {
+    render_image_scale   = frame_budgets[level].render_scale;
+    frame_buffer_resized = true;
+  }
+}
+
+void frame_governor::apply(scene_transform& transform) const
+{
+  const frame_budget& budget = frame_budgets[level];
+
+  transform.surface_rounds = budget.surface_rounds;
+  transform.iso_rounds     = budget.iso_rounds;
+  transform.slice_steps    = budget.slice_steps;
+  transform.tol_scale      = budget.tol_scale;
+}
@@ -0,0 +1,121 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include "error_vulkan.cpp"
+
+
+// gpu timer, brackets recorded work with a pair of timestamp queries
+
+struct gpu_timer
+{
+  VkQueryPool pool;
+  double      period;  // nanoseconds per timestamp tick
+  bool        supported;
+
+  // ---
+
+  gpu_timer();
+
+  gpu_timer(const gpu_timer& oth)            = delete;
+  gpu_timer& operator=(const gpu_timer& oth) = delete;
+
+  ~gpu_timer();
+
+  // ---
+
+  void start(VkCommandBuffer* command_buffer);
+  void stop(VkCommandBuffer* command_buffer);
+
+  // only valid once the submission containing start / stop has completed
+  bool elapsed_ms(double& ms);
+};
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+gpu_timer::gpu_timer() :
+pool(VK_NULL_HANDLE), period(0.), supported(false)
+{
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+  u32 nqueue_families = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &nqueue_families,
+                                           nullptr);
+  std::vector<VkQueueFamilyProperties> queue_families(nqueue_families);
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &nqueue_families,
+                                           queue_families.data());
+
+  u32 valid_bits = queue_families[queue_family_indices.graphics]
+                   .timestampValidBits;
+
+  supported = properties.limits.timestampComputeAndGraphics && valid_bits > 0;
+  period    = (double)properties.limits.timestampPeriod;
+
+  if (!supported)
+    return;
+
+  VkQueryPoolCreateInfo ci{};
+  ci.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  ci.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+  ci.queryCount = 2;
+  VK_CHECK(vkCreateQueryPool(device, &ci, nullptr, &pool),
+           "timestamp query pool creation failed!");
+}
+
+gpu_timer::~gpu_timer()
+{
+  vkDestroyQueryPool(device, pool, nullptr);
+}
+
+void gpu_timer::start(VkCommandBuffer* command_buffer)
+{
+  if (!supported)
+    return;
+
+  vkCmdResetQueryPool(*command_buffer, pool, 0, 2);
+  vkCmdWriteTimestamp2(*command_buffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                       pool, 0);
+}
+
+void gpu_timer::stop(VkCommandBuffer* command_buffer)
+{
+  if (!supported)
+    return;
+
+  vkCmdWriteTimestamp2(*command_buffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                       pool, 1);
+}
+
+bool gpu_timer::elapsed_ms(double& ms)
+{
+  if (!supported)
+    return false;
+
+  u64 stamps[2];
+  VkResult res = vkGetQueryPoolResults(device, pool, 0, 2, sizeof(stamps),
+                                       stamps, sizeof(u64),
+                                       VK_QUERY_RESULT_64_BIT);
+  if (res != VK_SUCCESS)
+    return false;
+
+  ms = (double)(stamps[1] - stamps[0]) * period * 1e-6;
+  return true;
+}
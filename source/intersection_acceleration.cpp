@@ -86,12 +86,13 @@ struct render_metadata
 {
   aabb              domain_bbox;
   std::vector<aabb> elem_bboxes;
+  glm::vec2         domain_output_bounds;
 };
 
 
 struct kdtree
 {
-  static constexpr int max_depth = 21;
+  static constexpr int max_depth = 21;  // < packet_stack_size, kd_packet.glsl
   aabb                 bbox;
   std::vector<kdnode>  nodes;
   std::vector<int>     leaf_elements;
@@ -0,0 +1,259 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "proxy.cpp"
+
+
+// Isosurface triangle mesh for the mesh path. The contours are extracted once
+// on the device (see shaders/iso_mesh.glsl) and re-extracted only when the
+// isovalues change, frames in between just rasterize the mesh. A count pass
+// sizes every element's share of the mesh, the host scans the counts into
+// offsets and an emit pass writes the compacted vertices and triangles.
+
+struct iso_mesh_params  // must match shaders/iso_mesh.glsl
+{
+  u32   subdiv;
+  u32   niso;
+  float isovalues[max_isovalues];
+};
+
+struct iso_mesh
+{
+  dbuffer<vertex> vertices;
+  dbuffer<u32>    indices;
+  u32             nindices;
+
+  // the contours the mesh was extracted for, valid is false before the first
+  // extraction
+  bool            valid;
+  iso_mesh_params params;
+
+  // frames the view has been still, exact raycasting takes over once there
+  // are "iso_mesh_still_frames" of them (if iso_mesh_exact_when_still)
+  glm::mat4 view;
+  glm::mat4 proj;
+  u32       still_frames;
+
+  // output and geometry basis values at the grid nodes
+  dbuffer<float> basis_p;
+  dbuffer<float> basis_q;
+
+  dbuffer<iso_mesh_params> d_params;
+  dbuffer<glm::uvec2>      d_counts;  // per element (vertices, triangles)
+
+  // ---
+
+  iso_mesh(const specialization_constants& constants, u32 nelem);
+
+  // re-extracts if the contours in the scene transform have changed
+  void update(raycast_data& rcdata, const specialization_constants& constants,
+              const scene_transform& transform);
+};
+
+const u32 iso_mesh_still_frames = 8;
+
+// grid cells along each element edge, must not exceed max_mesh_subdiv in
+// shaders/iso_mesh.glsl
+u32 iso_mesh_subdiv(u32 p);
+
+// rasterizes the mesh, or raycasts with "exact_pass" once the view is still
+void record_iso_mesh_command_buffer(
+u32 swap_chain_image, graphics_pipeline& mesh_pipeline,
+compute_pass& exact_pass, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, iso_mesh& mesh, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+u32 iso_mesh_subdiv(u32 p)
+{
+  return std::min(std::max(2 * p, 4u), 6u);
+}
+
+iso_mesh::iso_mesh(const specialization_constants& constants, u32 nelem) :
+vertices(),
+indices(),
+nindices(0),
+valid(false),
+params{},
+view(1.f),
+proj(1.f),
+still_frames(0),
+basis_p(),
+basis_q(),
+d_params(1),
+d_counts(nelem)
+{
+  dmalloc(d_params);
+  dmalloc(d_counts);
+
+  // tabulate both bases at the grid nodes (see shaders/precomp_basis.comp)
+
+  u32 subdiv = iso_mesh_subdiv(constants.p);
+  u32 nnodes = (subdiv + 1) * (subdiv + 1) * (subdiv + 1);
+  u32 nbfp   = (constants.p + 1) * (constants.p + 1) * (constants.p + 1);
+  u32 nbfq   = (constants.q + 1) * (constants.q + 1) * (constants.q + 1);
+
+  params.subdiv = subdiv;
+
+  basis_p = dbuffer<float>(nnodes * nbfp);
+  basis_q = dbuffer<float>(nnodes * nbfq);
+  dmalloc(basis_p);
+  dmalloc(basis_q);
+
+  dbuffer<u32> d_subdiv(1);
+  dbuffer<u32> d_order(1);
+  dmalloc(d_subdiv);
+  dmalloc(d_order);
+  memcpy_htod(d_subdiv, &subdiv);
+
+  compute_pipeline comp_basis(SHADER_DIR "precomp_basis.spv", 3, constants);
+  comp_basis.dset.update(d_subdiv, 0);
+  comp_basis.dset.update(d_order,  1);
+
+  u32 p = constants.p;
+  memcpy_htod(d_order, &p);
+  comp_basis.dset.update(basis_p, 2);
+  comp_basis.run((nnodes * nbfp + (256 - 1)) / 256, 1, 1);
+
+  u32 q = constants.q;
+  memcpy_htod(d_order, &q);
+  comp_basis.dset.update(basis_q, 2);
+  comp_basis.run((nnodes * nbfq + (256 - 1)) / 256, 1, 1);
+}
+
+void iso_mesh::update(raycast_data& rcdata,
+                      const specialization_constants& constants,
+                      const scene_transform& transform)
+{
+  iso_mesh_params current = params;
+  current.niso = transform.niso;
+  for (u32 i = 0; i < max_isovalues; ++i)
+    current.isovalues[i] = transform.isovalues[i / 4][i % 4];
+
+  if (valid && memcmp(&current, &params, sizeof(iso_mesh_params)) == 0)
+  {
+    return;
+  }
+
+  valid  = true;
+  params = current;
+  memcpy_htod(d_params, &params);
+
+  // one workgroup per element, spread over y past the x dispatch limit
+
+  u32 nelem = d_counts.nelems;
+  u32 gx    = std::min(nelem, 65535u);
+  u32 gy    = (nelem + gx - 1) / gx;
+
+  auto bind = [&](compute_pipeline& pass) {
+    pass.dset.update(rcdata.d_geom,          0);
+    pass.dset.update(rcdata.d_nodes,         1);
+    pass.dset.update(rcdata.d_state,         2);
+    pass.dset.update(rcdata.d_output_bounds, 3);
+    pass.dset.update(d_params,               4);
+    pass.dset.update(basis_p,                5);
+    pass.dset.update(basis_q,                6);
+    pass.dset.update(d_counts,               7);
+  };
+
+  compute_pipeline comp_count(SHADER_DIR "iso_mesh_count.spv", 8, constants);
+  bind(comp_count);
+  comp_count.run(gx, gy, 1);
+
+  // exclusive scan of the counts into each element's offsets
+
+  std::vector<glm::uvec2> counts(nelem);
+  memcpy_dtoh(counts.data(), d_counts);
+
+  glm::uvec2 total(0);
+  for (u32 ei = 0; ei < nelem; ++ei)
+  {
+    glm::uvec2 count = counts[ei];
+    counts[ei]       = total;
+    total           += count;
+  }
+
+  memcpy_htod(d_counts, counts.data());
+
+  // empty buffers can't be created, an empty mesh keeps one unused element
+
+  vertices = dbuffer<vertex>(std::max(total.x, 1u),
+  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+  indices = dbuffer<u32>(std::max(3 * total.y, 1u),
+  VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+  dmalloc(vertices);
+  dmalloc(indices);
+  nindices = 3 * total.y;
+
+  compute_pipeline comp_emit(SHADER_DIR "iso_mesh_emit.spv", 10, constants);
+  bind(comp_emit);
+  comp_emit.dset.update(vertices, 8);
+  comp_emit.dset.update(indices,  9);
+  comp_emit.run(gx, gy, 1);
+}
+
+void record_iso_mesh_command_buffer(
+u32 swap_chain_image, graphics_pipeline& mesh_pipeline,
+compute_pass& exact_pass, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, iso_mesh& mesh, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const scene_transform& transform = scene_ubo.host_data;
+
+  if (transform.view == mesh.view && transform.proj == mesh.proj)
+  {
+    mesh.still_frames = std::min(mesh.still_frames + 1, iso_mesh_still_frames);
+  }
+  else
+  {
+    mesh.still_frames = 0;
+    mesh.view         = transform.view;
+    mesh.proj         = transform.proj;
+  }
+
+  if (iso_mesh_exact_when_still && mesh.still_frames == iso_mesh_still_frames)
+  {
+    record_tiled_raycast_command_buffer(
+    swap_chain_image, exact_pass, ui_pipeline, ui_list, scene_ubo,
+    target_dset, solution_dset, timer, command_buffer);
+  }
+  else
+  {
+    record_proxy_raycast_command_buffer(
+    swap_chain_image, mesh_pipeline, ui_pipeline, ui_list, scene_ubo,
+    solution_dset, mesh.vertices, mesh.indices, mesh.nindices, timer,
+    command_buffer);
+  }
+}
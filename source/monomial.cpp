@@ -0,0 +1,137 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <cmath>
+#include <vector>
+
+#include "pipeline.cpp"
+
+
+// 1d nodal (equispaced Lagrange) to monomial coefficient transform, row major
+
+std::vector<float> lagrange_to_monomial(u32 p);
+
+
+// converts device resident nodes and state to tensor monomial coefficients
+// (shaders must then be specialized with monomial = true)
+
+void monomial_transform(dbuffer<dg_solution>& d_geom, dbuffer<float>& d_nodes,
+                        dbuffer<float>& d_state, const dg_solution& solution,
+                        const specialization_constants& constants);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+std::vector<float> lagrange_to_monomial(u32 p)
+{
+  // Monomial coefficients a of the polynomial with nodal values c satisfy
+  // V a = c with V_ik = x_i^k, so the transform is the inverse Vandermonde
+  // matrix. It is formed in double since it is poorly conditioned at high
+  // order.
+
+  u32 n = p + 1;
+
+  std::vector<double> v(n * n);
+  std::vector<double> vinv(n * n, 0.);
+
+  for (u32 i = 0; i < n; ++i)
+  {
+    double xi = (p == 0) ? 0. : double(i) / double(p);
+    double xk = 1.;
+    for (u32 k = 0; k < n; ++k)
+    {
+      v[n * i + k] = xk;
+      xk          *= xi;
+    }
+    vinv[n * i + i] = 1.;
+  }
+
+  // Gauss-Jordan elimination with partial pivoting
+
+  for (u32 c = 0; c < n; ++c)
+  {
+    u32 piv = c;
+    for (u32 r = c + 1; r < n; ++r)
+    {
+      if (fabs(v[n * r + c]) > fabs(v[n * piv + c])) piv = r;
+    }
+
+    for (u32 k = 0; k < n; ++k)
+    {
+      std::swap(v[n * c + k],    v[n * piv + k]);
+      std::swap(vinv[n * c + k], vinv[n * piv + k]);
+    }
+
+    double diag = v[n * c + c];
+    for (u32 k = 0; k < n; ++k)
+    {
+      v[n * c + k]    /= diag;
+      vinv[n * c + k] /= diag;
+    }
+
+    for (u32 r = 0; r < n; ++r)
+    {
+      if (r == c) continue;
+
+      double f = v[n * r + c];
+      for (u32 k = 0; k < n; ++k)
+      {
+        v[n * r + k]    -= f * v[n * c + k];
+        vinv[n * r + k] -= f * vinv[n * c + k];
+      }
+    }
+  }
+
+  std::vector<float> transform(n * n);
+  for (u32 i = 0; i < n * n; ++i)
+  {
+    transform[i] = float(vinv[i]);
+  }
+
+  return transform;
+}
+
+
+void monomial_transform(dbuffer<dg_solution>& d_geom, dbuffer<float>& d_nodes,
+                        dbuffer<float>& d_state, const dg_solution& solution,
+                        const specialization_constants& constants)
+{
+  compute_pipeline comp_transform(SHADER_DIR "monomial_transform.spv", 5,
+                                  constants);
+
+  std::vector<float> qtransform = lagrange_to_monomial(solution.q);
+  std::vector<float> ptransform = lagrange_to_monomial(solution.p);
+
+  dbuffer<float> d_qtransform(qtransform.size());
+  dbuffer<float> d_ptransform(ptransform.size());
+
+  dmalloc(d_qtransform);
+  dmalloc(d_ptransform);
+
+  memcpy_htod(d_qtransform, qtransform.data());
+  memcpy_htod(d_ptransform, ptransform.data());
+
+  comp_transform.dset.update(d_geom,       0);
+  comp_transform.dset.update(d_nodes,      1);
+  comp_transform.dset.update(d_state,      2);
+  comp_transform.dset.update(d_qtransform, 3);
+  comp_transform.dset.update(d_ptransform, 4);
+  comp_transform.run((solution.nelem + (128 - 1)) / 128, 1, 1);
+}
@@ -26,6 +26,26 @@ std::vector<char> read_shader(const std::string& address);
 VkShaderModule make_shader_module(const std::vector<char>& code);
 
 
+// pipeline specialization (constant ids match shaders/specialization.glsl)
+
+const u32 nspecialization_constants = 4;
+
+struct specialization_constants
+{
+  u32 p;
+  u32 q;
+  s32 output;
+  VkBool32 monomial;
+
+  specialization_constants();
+  specialization_constants(const dg_solution& solution, output_type output_,
+                           bool monomial_);
+
+  VkSpecializationInfo info(
+  VkSpecializationMapEntry entries[nspecialization_constants]) const;
+};
+
+
 // descriptor set layout
 
 struct descriptor_set_layout
@@ -37,6 +57,7 @@ struct descriptor_set_layout
 
   descriptor_set_layout();
   descriptor_set_layout(u32 nbinding, VkDescriptorType descriptor_type);
+  descriptor_set_layout(const std::vector<VkDescriptorType>& descriptor_types);
 
   descriptor_set_layout(const descriptor_set_layout& oth)      = delete;
   descriptor_set_layout& operator=(descriptor_set_layout& oth) = delete;
@@ -78,6 +99,8 @@ struct descriptor_set
 
   template<typename T>
   void update(dbuffer<T>& buff, u32 binding);
+  void update_image(VkImageView view, VkImageLayout image_layout, u32 binding,
+                    VkSampler sampler = VK_NULL_HANDLE);
   void clean();
 };
 
@@ -102,6 +125,8 @@ struct graphics_pipeline
 
   bool vertex_input;
 
+  specialization_constants constants;
+
   // ---
 
   graphics_pipeline();
@@ -111,7 +136,8 @@ struct graphics_pipeline
                     VkAttachmentLoadOp color_load_op_, bool vertex_input_,
                     descriptor_set_layout& scene_layout_,
                     descriptor_set_layout& object_layout_,
-                    descriptor_set_layout& solution_layout_);
+                    descriptor_set_layout& solution_layout_,
+                    const specialization_constants& constants_);
 
   graphics_pipeline(const graphics_pipeline& oth)      = delete;
   graphics_pipeline& operator=(graphics_pipeline& oth) = delete;
@@ -141,7 +167,8 @@ struct compute_pipeline
 
   // ---
 
-  compute_pipeline(const std::string& shader, u64 nargs);
+  compute_pipeline(const std::string& shader, u64 nargs,
+                   const specialization_constants& constants);
 
   compute_pipeline(const compute_pipeline& oth)            = delete;
   compute_pipeline& operator=(const compute_pipeline& oth) = delete;
@@ -157,6 +184,44 @@ struct compute_pipeline
 };
 
 
+// compute pass (recorded into a caller's command buffer against descriptor
+// set layouts owned elsewhere, used for per-frame compute work)
+
+struct compute_pass
+{
+  VkPipeline       pipeline;
+  VkPipelineLayout layout;
+  u32              push_constant_size;
+
+  // ---
+
+  compute_pass();
+  compute_pass(const std::string& shader,
+               const std::vector<descriptor_set_layout*>& set_layouts,
+               u32 push_constant_size_,
+               const specialization_constants& constants);
+
+  compute_pass(const compute_pass& oth)            = delete;
+  compute_pass& operator=(const compute_pass& oth) = delete;
+
+  compute_pass(compute_pass&& oth) noexcept;
+  compute_pass& operator=(compute_pass&& oth) noexcept;
+
+  ~compute_pass();
+
+  // ---
+
+  void record(VkCommandBuffer* command_buffer,
+              const std::vector<VkDescriptorSet>& dsets,
+              const void* push_constants, u32 gcx, u32 gcy, u32 gcz) const;
+  void record_indirect(VkCommandBuffer* command_buffer,
+                       const std::vector<VkDescriptorSet>& dsets,
+                       const void* push_constants, VkBuffer args,
+                       VkDeviceSize offset) const;
+  void clean();
+};
+
+
 /* IMPLEMENTATION ----------------------------------------------------------- */
 
 
@@ -189,19 +254,70 @@ VkShaderModule make_shader_module(const std::vector<char>& code)
   return shader_module;
 }
 
+/*
+ * specialization_constants ----------------------------------------------------
+ */
+
+specialization_constants::specialization_constants() :
+p(1), q(1), output((s32)output_type::mach), monomial(VK_FALSE)
+{}
+
+specialization_constants::specialization_constants(const dg_solution& solution,
+                                                   output_type output_,
+                                                   bool monomial_) :
+p(solution.p),
+q(solution.q),
+output((s32)output_),
+monomial(monomial_ ? VK_TRUE : VK_FALSE)
+{}
+
+VkSpecializationInfo specialization_constants::info(
+VkSpecializationMapEntry entries[nspecialization_constants]) const
+{
+  entries[0].constantID = 0;
+  entries[0].offset     = offsetof(specialization_constants, p);
+  entries[0].size       = sizeof(u32);
+
+  entries[1].constantID = 1;
+  entries[1].offset     = offsetof(specialization_constants, q);
+  entries[1].size       = sizeof(u32);
+
+  entries[2].constantID = 2;
+  entries[2].offset     = offsetof(specialization_constants, output);
+  entries[2].size       = sizeof(s32);
+
+  entries[3].constantID = 3;
+  entries[3].offset     = offsetof(specialization_constants, monomial);
+  entries[3].size       = sizeof(VkBool32);
+
+  VkSpecializationInfo spec_info{};
+  spec_info.mapEntryCount = nspecialization_constants;
+  spec_info.pMapEntries   = entries;
+  spec_info.dataSize      = sizeof(specialization_constants);
+  spec_info.pData         = this;
+
+  return spec_info;
+}
+
 /*
  * descriptor_set_layout -------------------------------------------------------
  */
 
 descriptor_set_layout::descriptor_set_layout(u32 nbinding,
-                                             VkDescriptorType descriptor_type)
+                                             VkDescriptorType descriptor_type) :
+descriptor_set_layout(std::vector<VkDescriptorType>(nbinding, descriptor_type))
+{}
+
+descriptor_set_layout::descriptor_set_layout(
+const std::vector<VkDescriptorType>& descriptor_types)
 {
+  u32 nbinding    = descriptor_types.size();
   layout_bindings = std::vector<VkDescriptorSetLayoutBinding>(nbinding);
 
   for (u32 bi = 0; bi < nbinding; ++bi)
   {
     layout_bindings[bi].binding            = bi;
-    layout_bindings[bi].descriptorType     = descriptor_type;
+    layout_bindings[bi].descriptorType     = descriptor_types[bi];
     layout_bindings[bi].descriptorCount    = 1;
     layout_bindings[bi].stageFlags         = VK_SHADER_STAGE_VERTEX_BIT |
                                              VK_SHADER_STAGE_FRAGMENT_BIT |
@@ -258,16 +374,19 @@ descriptor_set_layout::~descriptor_set_layout()
 descriptor_set::descriptor_set(descriptor_set_layout* _layout) :
 layout(_layout), dpool(VK_NULL_HANDLE), dset(VK_NULL_HANDLE)
 {
-  /* make the descriptor pool */
+  /* make the descriptor pool (one descriptor per binding) */
 
-  VkDescriptorPoolSize pool_size{};
-  pool_size.descriptorCount = layout->layout_bindings.size();
-  pool_size.type            = layout->layout_bindings[0].descriptorType;
+  std::vector<VkDescriptorPoolSize> pool_sizes(layout->layout_bindings.size());
+  for (usize bi = 0; bi < pool_sizes.size(); ++bi)
+  {
+    pool_sizes[bi].descriptorCount = 1;
+    pool_sizes[bi].type = layout->layout_bindings[bi].descriptorType;
+  }
 
   VkDescriptorPoolCreateInfo pool_info{};
   pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-  pool_info.poolSizeCount = 1;
-  pool_info.pPoolSizes    = &pool_size;
+  pool_info.poolSizeCount = pool_sizes.size();
+  pool_info.pPoolSizes    = pool_sizes.data();
   pool_info.maxSets       = 1;
 
   VK_CHECK(vkCreateDescriptorPool(device, &pool_info, nullptr, &dpool),
@@ -353,6 +472,36 @@ void descriptor_set::update(dbuffer<T>& buff, u32 binding)
   vkUpdateDescriptorSets(device, 1, &descriptor_write, 0, nullptr);
 }
 
+void descriptor_set::update_image(VkImageView view, VkImageLayout image_layout,
+                                  u32 binding, VkSampler sampler)
+{
+  if (binding >= layout->layout_bindings.size())
+  {
+    VKTERMINATE(
+    "attempted to bind to slot %d, descriptor set only has %d bindings!",
+    (int)binding, (int)layout->layout_bindings.size());
+  }
+
+  VkDescriptorImageInfo image_info{};
+  image_info.sampler     = sampler;
+  image_info.imageView   = view;
+  image_info.imageLayout = image_layout;
+
+  VkWriteDescriptorSet descriptor_write{};
+  descriptor_write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptor_write.dstSet          = dset;
+  descriptor_write.dstBinding      = binding;
+  descriptor_write.dstArrayElement = 0;
+  descriptor_write.descriptorType =
+  layout->layout_bindings[binding].descriptorType;
+  descriptor_write.descriptorCount  = 1;
+  descriptor_write.pBufferInfo      = nullptr;
+  descriptor_write.pImageInfo       = &image_info;
+  descriptor_write.pTexelBufferView = nullptr;
+
+  vkUpdateDescriptorSets(device, 1, &descriptor_write, 0, nullptr);
+}
+
 descriptor_set::~descriptor_set()
 {
   clean();
@@ -374,7 +523,8 @@ framebuffers(),
 scene_layout(       nullptr),
 object_layout(      nullptr),
 solution_layout(    nullptr),
-vertex_input(       true)
+vertex_input(       true),
+constants()
 {}
 
 graphics_pipeline::graphics_pipeline(std::string vertex_shader_file,
@@ -383,7 +533,8 @@ graphics_pipeline::graphics_pipeline(std::string vertex_shader_file,
                                      bool vertex_input_,
                                      descriptor_set_layout& scene_layout_,
                                      descriptor_set_layout& object_layout_,
-                                     descriptor_set_layout& solution_layout_) :
+                                     descriptor_set_layout& solution_layout_,
+                                     const specialization_constants& constants_) :
 pipeline(           VK_NULL_HANDLE),
 render_pass(        VK_NULL_HANDLE),
 layout(             VK_NULL_HANDLE),
@@ -394,7 +545,8 @@ framebuffers(),
 scene_layout(       &scene_layout_),
 object_layout(      &object_layout_),
 solution_layout(    &solution_layout_),
-vertex_input(       vertex_input_)
+vertex_input(       vertex_input_),
+constants(          constants_)
 {
   std::vector<char> vert_shader_code = read_shader(vertex_shader_file);
   std::vector<char> frag_shader_code = read_shader(fragment_shader_file);
@@ -414,7 +566,8 @@ framebuffers(       std::move(oth.framebuffers)),
 scene_layout(       std::move(oth.scene_layout)),
 object_layout(      std::move(oth.object_layout)),
 solution_layout(    std::move(oth.solution_layout)),
-vertex_input(       std::move(oth.vertex_input))
+vertex_input(       std::move(oth.vertex_input)),
+constants(          std::move(oth.constants))
 {
   oth.pipeline           = VK_NULL_HANDLE;
   oth.render_pass        = VK_NULL_HANDLE;
@@ -454,7 +607,7 @@ void graphics_pipeline::update_swap_chain_dependencies()
 
   {
     VkAttachmentDescription color_attachment{};
-    color_attachment.format         = swap_chain_image_format;
+    color_attachment.format         = render_image_format;
     color_attachment.samples        = VK_SAMPLE_COUNT_1_BIT;
     color_attachment.loadOp         = color_load_op;
     color_attachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
@@ -537,19 +690,24 @@ void graphics_pipeline::update_swap_chain_dependencies()
   render_extent.height = swap_chain_extent.height / render_image_scale;
 
   {
-    // shader stages
+    // shader stages (both share the solution specialization)
+    VkSpecializationMapEntry spec_entries[nspecialization_constants];
+    VkSpecializationInfo spec_info = constants.info(spec_entries);
+
     VkPipelineShaderStageCreateInfo vert_create_info{};
     vert_create_info.sType =
     VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     vert_create_info.stage  = VK_SHADER_STAGE_VERTEX_BIT;
     vert_create_info.module = vert_shader_module;
     vert_create_info.pName  = "main";
+    vert_create_info.pSpecializationInfo = &spec_info;
     VkPipelineShaderStageCreateInfo frag_create_info{};
     frag_create_info.sType =
     VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     frag_create_info.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
     frag_create_info.module = frag_shader_module;
     frag_create_info.pName  = "main";
+    frag_create_info.pSpecializationInfo = &spec_info;
     VkPipelineShaderStageCreateInfo shader_stage_create_info[] = {
     vert_create_info, frag_create_info};
 
@@ -724,7 +882,8 @@ void graphics_pipeline::update_swap_chain_dependencies()
  * compute_pipeline ------------------------------------------------------------
  */
 
-compute_pipeline::compute_pipeline(const std::string& shader, u64 nargs)
+compute_pipeline::compute_pipeline(const std::string& shader, u64 nargs,
+                                   const specialization_constants& constants)
 {
   /*
    * descriptor set creation ---------------------------------------------------
@@ -741,11 +900,15 @@ compute_pipeline::compute_pipeline(const std::string& shader, u64 nargs)
   std::vector<char> shader_code = read_shader(shader);
   VkShaderModule shader_module  = make_shader_module(shader_code);
 
+  VkSpecializationMapEntry spec_entries[nspecialization_constants];
+  VkSpecializationInfo spec_info = constants.info(spec_entries);
+
   VkPipelineShaderStageCreateInfo shader_ci{};
   shader_ci.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
   shader_ci.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
   shader_ci.module = shader_module;
   shader_ci.pName  = "main";
+  shader_ci.pSpecializationInfo = &spec_info;
 
   /*
    * pipeline layout creation --------------------------------------------------
@@ -836,3 +999,142 @@ void compute_pipeline::run(u32 gcx, u32 gcy, u32 gcz)
   vkDestroyFence(device, fence, nullptr);
   vkFreeCommandBuffers(device, compute_command_pool, 1, &command_buffer);
 }
+
+/*
+ * compute_pass ----------------------------------------------------------------
+ */
+
+compute_pass::compute_pass() :
+pipeline(           VK_NULL_HANDLE),
+layout(             VK_NULL_HANDLE),
+push_constant_size( 0)
+{}
+
+compute_pass::compute_pass(
+const std::string& shader,
+const std::vector<descriptor_set_layout*>& set_layouts,
+u32 push_constant_size_, const specialization_constants& constants) :
+pipeline(           VK_NULL_HANDLE),
+layout(             VK_NULL_HANDLE),
+push_constant_size( push_constant_size_)
+{
+  std::vector<char> shader_code = read_shader(shader);
+  VkShaderModule shader_module  = make_shader_module(shader_code);
+
+  VkSpecializationMapEntry spec_entries[nspecialization_constants];
+  VkSpecializationInfo spec_info = constants.info(spec_entries);
+
+  VkPipelineShaderStageCreateInfo shader_ci{};
+  shader_ci.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shader_ci.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+  shader_ci.module = shader_module;
+  shader_ci.pName  = "main";
+  shader_ci.pSpecializationInfo = &spec_info;
+
+  std::vector<VkDescriptorSetLayout> descset_layouts(set_layouts.size());
+  for (u64 i = 0; i < set_layouts.size(); ++i)
+  {
+    descset_layouts[i] = set_layouts[i]->layout;
+  }
+
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_constant_range.offset     = 0;
+  push_constant_range.size       = push_constant_size;
+
+  VkPipelineLayoutCreateInfo layout_ci{};
+  layout_ci.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  layout_ci.setLayoutCount = descset_layouts.size();
+  layout_ci.pSetLayouts    = descset_layouts.data();
+  if (push_constant_size > 0)
+  {
+    layout_ci.pushConstantRangeCount = 1;
+    layout_ci.pPushConstantRanges    = &push_constant_range;
+  }
+
+  VK_CHECK(vkCreatePipelineLayout(device, &layout_ci, nullptr, &layout),
+           "compute pass layout creation failed for %s!", shader.c_str());
+
+  VkComputePipelineCreateInfo pipeline_ci{};
+  pipeline_ci.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_ci.stage  = shader_ci;
+  pipeline_ci.layout = layout;
+
+  VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_ci,
+                                    nullptr, &pipeline),
+           "compute pass creation failed for %s!", shader.c_str());
+
+  vkDestroyShaderModule(device, shader_module, nullptr);
+}
+
+compute_pass::compute_pass(compute_pass&& oth) noexcept :
+pipeline(           oth.pipeline),
+layout(             oth.layout),
+push_constant_size( oth.push_constant_size)
+{
+  oth.pipeline = VK_NULL_HANDLE;
+  oth.layout   = VK_NULL_HANDLE;
+}
+
+compute_pass& compute_pass::operator=(compute_pass&& oth) noexcept
+{
+  clean();
+
+  pipeline           = oth.pipeline;
+  layout             = oth.layout;
+  push_constant_size = oth.push_constant_size;
+
+  oth.pipeline = VK_NULL_HANDLE;
+  oth.layout   = VK_NULL_HANDLE;
+
+  return *this;
+}
+
+void compute_pass::clean()
+{
+  vkDestroyPipeline(device, pipeline, nullptr);
+  vkDestroyPipelineLayout(device, layout, nullptr);
+}
+
+compute_pass::~compute_pass()
+{
+  clean();
+}
+
+void compute_pass::record(VkCommandBuffer* command_buffer,
+                          const std::vector<VkDescriptorSet>& dsets,
+                          const void* push_constants, u32 gcx, u32 gcy,
+                          u32 gcz) const
+{
+  vkCmdBindPipeline(*command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+  vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          layout, 0, dsets.size(), dsets.data(), 0, nullptr);
+
+  if (push_constant_size > 0)
+  {
+    vkCmdPushConstants(*command_buffer, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       push_constant_size, push_constants);
+  }
+
+  vkCmdDispatch(*command_buffer, gcx, gcy, gcz);
+}
+
+void compute_pass::record_indirect(VkCommandBuffer* command_buffer,
+                                   const std::vector<VkDescriptorSet>& dsets,
+                                   const void* push_constants, VkBuffer args,
+                                   VkDeviceSize offset) const
+{
+  vkCmdBindPipeline(*command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+  vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          layout, 0, dsets.size(), dsets.data(), 0, nullptr);
+
+  if (push_constant_size > 0)
+  {
+    vkCmdPushConstants(*command_buffer, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       push_constant_size, push_constants);
+  }
+
+  vkCmdDispatchIndirect(*command_buffer, args, offset);
+}
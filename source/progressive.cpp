@@ -0,0 +1,173 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// progressive refinement, one ray per block of pixels while the view changes
+// and the remaining pixels of each block over the following still frames
+// (see shaders/progressive.glsl)
+
+const u32 progressive_block_log2 = 2;  // 4x4 blocks, at most 3
+
+struct progressive_constants
+{
+  u32 step;
+  u32 block_log2;
+};
+
+struct progressive_data
+{
+  u32 npixel;
+  u32 step;  // samples per block accumulated so far
+
+  // what the accumulation was rendered with, mode -1 if it is invalid
+  s32             mode;
+  scene_transform transform;
+  const float*    cmap;
+
+  dbuffer<glm::vec4> d_accum;
+
+  descriptor_set_layout layout;
+  descriptor_set        dset;
+
+  // ---
+
+  progressive_data();
+
+  // buffers are sized by the render image, call after swap chain changes
+  void resize(VkExtent2D extent);
+};
+
+void make_progressive_passes(
+std::unordered_map<std::string, compute_pass>& passes,
+const std::vector<descriptor_set_layout*>& layouts,
+const specialization_constants& constants);
+
+void record_progressive_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, progressive_data& pdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+progressive_data::progressive_data() :
+npixel(0),
+step(0),
+mode(-1),
+transform(),
+cmap(nullptr),
+d_accum(),
+layout(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+dset(&layout)
+{}
+
+void progressive_data::resize(VkExtent2D extent)
+{
+  npixel = extent.width * extent.height;
+  mode   = -1;
+
+  d_accum = dbuffer<glm::vec4>(npixel);
+  dmalloc(d_accum);
+
+  dset.update(d_accum, 0);
+}
+
+void make_progressive_passes(
+std::unordered_map<std::string, compute_pass>& passes,
+const std::vector<descriptor_set_layout*>& layouts,
+const specialization_constants& constants)
+{
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    if (!raycast_path_supported[mi][(int)raycast_path::progressive])
+      continue;
+
+    std::string name = std::string("raycast_") + raycast_mode_names[mi] +
+                       "_progressive";
+    passes.emplace(name, compute_pass(SHADER_DIR + name + ".spv", layouts,
+                                      sizeof(progressive_constants),
+                                      constants));
+  }
+}
+
+void record_progressive_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, progressive_data& pdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const compute_pass& raycast = passes.at(mode_name + "_progressive");
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  pdata.dset.dset,
+  };
+
+  // any change to what the accumulated colors depend on starts over
+
+  if (pdata.mode != (s32)RAYCAST_MODE || pdata.cmap != colormap ||
+      memcmp(&pdata.transform, &scene_ubo.host_data,
+             sizeof(scene_transform)) != 0)
+  {
+    pdata.step      = 0;
+    pdata.mode      = (s32)RAYCAST_MODE;
+    pdata.transform = scene_ubo.host_data;
+    pdata.cmap      = colormap;
+  }
+
+  progressive_constants pc;
+  pc.step       = pdata.step;
+  pc.block_log2 = progressive_block_log2;
+
+  VkExtent2D extent = scaled_render_extent();
+
+  begin_compute_raycast_command_buffer(command_buffer);
+
+  timer.start(command_buffer);
+
+  raycast.record(command_buffer, dsets, &pc,
+                 (extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+                 (extent.height + raycast_tile_size - 1) / raycast_tile_size,
+                 1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
+
+  // once converged the kernel only resolves the accumulated image
+
+  u32 nsample = 1u << (2 * progressive_block_log2);
+  if (pdata.step < nsample)
+    ++pdata.step;
+}
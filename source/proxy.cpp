@@ -0,0 +1,195 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#pragma once
+
+
+#include <vector>
+#include <unordered_map>
+
+#include "recording.cpp"
+#include "raycast_data.cpp"
+
+
+// Linear triangle proxy of the exterior faces for the raster path. Each face
+// is tessellated into a regular grid in its reference coordinates, vertices
+// carry their element and face (in the color attribute) and reference
+// coordinates so fragments can refine the hit on the curved face (see
+// shaders/raycast_proxy_frag.frag).
+
+struct face_proxy
+{
+  dbuffer<vertex> vertices;
+  dbuffer<u32>    indices;
+
+  // ---
+
+  // needs the boundary faces in rcdata
+  face_proxy(raycast_data& rcdata, const specialization_constants& constants);
+};
+
+// proxy quads along each face edge, must match shaders/face_proxy.comp
+u32 face_proxy_subdiv(u32 q);
+
+// draws "nindices" of a triangle mesh carrying (elem, face or contour, 0) and
+// reference coordinates per vertex, also used by the isosurface mesh path
+void record_proxy_raycast_command_buffer(
+u32 swap_chain_image, graphics_pipeline& proxy_pipeline,
+graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& solution_dset,
+dbuffer<vertex>& vertices, dbuffer<u32>& indices, u32 nindices,
+gpu_timer& timer, VkCommandBuffer* command_buffer);
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+u32 face_proxy_subdiv(u32 q)
+{
+  return 2 * q;
+}
+
+face_proxy::face_proxy(raycast_data& rcdata,
+                       const specialization_constants& constants)
+{
+  u32 nface = rcdata.d_faces.nelems;
+  u32 n     = face_proxy_subdiv(constants.q);
+  u32 nfv   = (n + 1) * (n + 1);
+
+  vertices = dbuffer<vertex>(nface * nfv,
+  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+  indices = dbuffer<u32>(6 * nface * n * n,
+  VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+  dmalloc(vertices);
+  dmalloc(indices);
+
+  // the grid connectivity is the same on every face
+
+  std::vector<u32> host_indices(indices.nelems);
+  u32 ii = 0;
+  for (u32 f = 0; f < nface; ++f)
+  {
+    for (u32 j = 0; j < n; ++j)
+    {
+      for (u32 i = 0; i < n; ++i)
+      {
+        u32 v00 = f * nfv + j * (n + 1) + i;
+        u32 v10 = v00 + 1;
+        u32 v01 = v00 + (n + 1);
+        u32 v11 = v01 + 1;
+
+        host_indices[ii++] = v00;
+        host_indices[ii++] = v10;
+        host_indices[ii++] = v11;
+        host_indices[ii++] = v00;
+        host_indices[ii++] = v11;
+        host_indices[ii++] = v01;
+      }
+    }
+  }
+
+  memcpy_htod(indices, host_indices.data());
+
+  // vertex positions come from the element mapping, evaluated on the device
+
+  compute_pipeline comp_face_proxy(SHADER_DIR "face_proxy.spv", 5, constants);
+  comp_face_proxy.dset.update(rcdata.d_geom,  0);
+  comp_face_proxy.dset.update(rcdata.d_nodes, 1);
+  comp_face_proxy.dset.update(rcdata.d_state, 2);
+  comp_face_proxy.dset.update(rcdata.d_faces, 3);
+  comp_face_proxy.dset.update(vertices,       4);
+  comp_face_proxy.run((nface * nfv + (128 - 1)) / 128, 1, 1);
+}
+
+void record_proxy_raycast_command_buffer(
+u32 swap_chain_image, graphics_pipeline& proxy_pipeline,
+graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& solution_dset,
+dbuffer<vertex>& vertices, dbuffer<u32>& indices, u32 nindices,
+gpu_timer& timer, VkCommandBuffer* command_buffer)
+{
+  const u32 nclear_values                  = 2;
+  VkClearValue clear_values[nclear_values] = {};
+  clear_values[0].color                    = {{0.0f, 0.0f, 0.0f, 1.0f}};
+  clear_values[1].depthStencil             = {1.0f, 0};
+
+  VkDeviceSize offsets[] = {0};
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.pInheritanceInfo = nullptr;
+
+  VK_CHECK(vkBeginCommandBuffer(*command_buffer, &begin_info),
+           "failed to start a command buffer!");
+
+  timer.start(command_buffer);
+
+  /* proxy pass */
+
+  VkRenderPassBeginInfo proxy_pass_info{};
+  proxy_pass_info.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  proxy_pass_info.renderPass  = proxy_pipeline.render_pass;
+  proxy_pass_info.framebuffer = proxy_pipeline.framebuffers[0];
+  proxy_pass_info.renderArea.offset = {0, 0};
+  proxy_pass_info.renderArea.extent = scaled_render_extent();
+  proxy_pass_info.clearValueCount   = nclear_values;
+  proxy_pass_info.pClearValues      = clear_values;
+
+  vkCmdBeginRenderPass(*command_buffer, &proxy_pass_info,
+                       VK_SUBPASS_CONTENTS_INLINE);
+
+  vkCmdBindPipeline(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    proxy_pipeline.pipeline);
+
+  vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          proxy_pipeline.layout, 0, 1, &scene_ubo.dset.dset, 0,
+                          nullptr);
+
+  vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          proxy_pipeline.layout, 2, 1, &solution_dset.dset, 0,
+                          nullptr);
+
+  vkCmdBindVertexBuffers(*command_buffer, 0, 1, &vertices.buffer, offsets);
+
+  vkCmdBindIndexBuffer(*command_buffer, indices.buffer, 0,
+                       VK_INDEX_TYPE_UINT32);
+
+  vkCmdDrawIndexed(*command_buffer, nindices, 1, 0, 0, 0);
+
+  vkCmdEndRenderPass(*command_buffer);
+
+  timer.stop(command_buffer);
+
+  /* ui pass */
+
+  if (render_ui)
+  {
+    record_ui_pass(ui_pipeline, ui_list, scene_ubo, command_buffer);
+  }
+
+  // blit to full image
+
+  record_present_blit(swap_chain_image, command_buffer);
+
+  // --
+
+  VK_CHECK(vkEndCommandBuffer(*command_buffer),
+           "failed to end command buffer!");
+}
@@ -30,6 +30,9 @@ struct raycast_data
   // gpu-side pre-computes
   dbuffer<aabb>        d_bboxes;
   dbuffer<glm::vec2>   d_output_bounds;
+  dbuffer<elem_inverse_map> d_elem_maps;
+  dbuffer<glm::vec4>   d_elem_warm;
+  dbuffer<glm::vec2>   d_subcell_bounds;
 
   // cpu augments to gpu pre-computes (to avoid atomics for portability)
   dbuffer<aabb>        d_domain_bbox;
@@ -39,8 +42,15 @@ struct raycast_data
   dbuffer<kdnode>      d_kdnodes;
   dbuffer<int>         d_kd_leaf_elements;
 
+  // exterior element faces (6 * elem + face) and their own k-d tree, bboxes
+  // are a gpu pre-compute
+  dbuffer<s32>         d_faces;
+  dbuffer<aabb>        d_face_bboxes;
+  dbuffer<kdnode>      d_face_kdnodes;
+  dbuffer<int>         d_face_kd_leaf_faces;
+
   // rendering options
-  dbuffer<float>       d_colormap;
+  texture              colormap_texture;  // 256 x 1, sampled linearly
   dbuffer<output_type> d_output;
 
 
@@ -49,6 +59,10 @@ struct raycast_data
 
   raycast_data();
 
+  // (re)fills the colormap texture from a 256 entry rgb colormap, the texture
+  // must not be in use by the device
+  void set_colormap(const float* map);
+
   void update_descset();
 };
 
@@ -58,16 +72,60 @@ d_nodes(),
 d_state(),
 d_bboxes(),
 d_output_bounds(),
+d_elem_maps(),
+d_elem_warm(),
+d_subcell_bounds(),
 d_domain_bbox(),
 d_domain_output_bounds(),
 d_kdnodes(),
 d_kd_leaf_elements(),
-d_colormap(),
+d_faces(),
+d_face_bboxes(),
+d_face_kdnodes(),
+d_face_kd_leaf_faces(),
+colormap_texture(),
 d_output(),
-raycast_layout(11, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+raycast_layout({
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 0  params
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 1  nodes
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 2  state
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 3  element bboxes
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 4  element output bounds
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 5  domain bbox
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 6  domain output bounds
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 7  k-d nodes
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 8  k-d leaf elements
+VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // 9  colormap
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 10 output option
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 11 element inverse maps
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 12 element warm starts
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 13 boundary faces
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 14 face bboxes
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 15 face k-d nodes
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 16 face k-d leaf faces
+VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // 17 subcell output bounds
+}),
 raycast_descset(&raycast_layout)
 {}
 
+void raycast_data::set_colormap(const float* map)
+{
+  const u32 cmap_size = 256;
+
+  if (colormap_texture.image == VK_NULL_HANDLE)
+    colormap_texture = texture(cmap_size, 1, VK_FORMAT_R8G8B8A8_UNORM);
+
+  u8 texels[4 * cmap_size];
+  for (u32 i = 0; i < cmap_size; ++i)
+  {
+    for (u32 c = 0; c < 3; ++c)
+      texels[4 * i + c] = (u8)(255.f * clamp(map[3 * i + c], 0.f, 1.f) + 0.5f);
+    texels[4 * i + 3] = 255;
+  }
+
+  colormap_texture.upload(texels, sizeof(texels));
+}
+
 void raycast_data::update_descset()
 {
   raycast_descset.update(d_geom,                 0);
@@ -79,6 +137,15 @@ void raycast_data::update_descset()
   raycast_descset.update(d_domain_output_bounds, 6);
   raycast_descset.update(d_kdnodes,              7);
   raycast_descset.update(d_kd_leaf_elements,     8);
-  raycast_descset.update(d_colormap,             9);
+  raycast_descset.update_image(colormap_texture.view,
+                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 9,
+                               colormap_texture.sampler);
   raycast_descset.update(d_output,               10);
+  raycast_descset.update(d_elem_maps,            11);
+  raycast_descset.update(d_elem_warm,            12);
+  raycast_descset.update(d_faces,                13);
+  raycast_descset.update(d_face_bboxes,          14);
+  raycast_descset.update(d_face_kdnodes,         15);
+  raycast_descset.update(d_face_kd_leaf_faces,   16);
+  raycast_descset.update(d_subcell_bounds,       17);
 }
@@ -25,15 +25,22 @@
 #include "buffers.cpp"
 #include "pipeline.cpp"
 #include "entity.cpp"
+#include "gpu_timer.cpp"
 
 
-void transition_image_layout(VkCommandBuffer* command_buffer, VkImage* image,
-                             VkPipelineStageFlags2 src_stages,
-                             VkPipelineStageFlags2 dst_stages,
-                             VkImageLayout old_layout, VkImageLayout new_layout)
+// edge length of the screen tiles used by the tiled compute raycaster, must
+// match shaders/raycast_compute.glsl
+const u32 raycast_tile_size = 8;
+
+
+void image_barrier(VkCommandBuffer* command_buffer, VkImage* image,
+                   VkImageAspectFlags aspect,
+                   VkPipelineStageFlags2 src_stages, VkAccessFlags2 src_access,
+                   VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access,
+                   VkImageLayout old_layout, VkImageLayout new_layout)
 {
   VkImageSubresourceRange imgrange{};
-  imgrange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  imgrange.aspectMask     = aspect;
   imgrange.baseMipLevel   = 0;
   imgrange.levelCount     = 1;
   imgrange.baseArrayLayer = 0;
@@ -43,9 +50,9 @@ void transition_image_layout(VkCommandBuffer* command_buffer, VkImage* image,
   imgbar.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
   imgbar.pNext               = nullptr;
   imgbar.srcStageMask        = src_stages;
-  imgbar.srcAccessMask       = 0;
+  imgbar.srcAccessMask       = src_access;
   imgbar.dstStageMask        = dst_stages;
-  imgbar.dstAccessMask       = 0;
+  imgbar.dstAccessMask       = dst_access;
   imgbar.oldLayout           = old_layout;
   imgbar.newLayout           = new_layout;
   imgbar.srcQueueFamilyIndex = 0;
@@ -68,12 +75,214 @@ void transition_image_layout(VkCommandBuffer* command_buffer, VkImage* image,
 }
 
 
+void memory_barrier(VkCommandBuffer* command_buffer,
+                    VkPipelineStageFlags2 src_stages, VkAccessFlags2 src_access,
+                    VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access)
+{
+  VkMemoryBarrier2 membar{};
+  membar.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+  membar.pNext         = nullptr;
+  membar.srcStageMask  = src_stages;
+  membar.srcAccessMask = src_access;
+  membar.dstStageMask  = dst_stages;
+  membar.dstAccessMask = dst_access;
+
+  VkDependencyInfo depinfo{};
+  depinfo.sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  depinfo.pNext                    = nullptr;
+  depinfo.dependencyFlags          = 0;
+  depinfo.memoryBarrierCount       = 1;
+  depinfo.pMemoryBarriers          = &membar;
+  depinfo.bufferMemoryBarrierCount = 0;
+  depinfo.pBufferMemoryBarriers    = nullptr;
+  depinfo.imageMemoryBarrierCount  = 0;
+  depinfo.pImageMemoryBarriers     = nullptr;
+
+  vkCmdPipelineBarrier2(*command_buffer, &depinfo);
+}
+
+
+// storage writes of one compute dispatch visible to the next, including its
+// indirect arguments
+void compute_barrier(VkCommandBuffer* command_buffer)
+{
+  memory_barrier(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                 VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                 VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                 VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                 VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                 VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+}
+
+
+void transition_image_layout(VkCommandBuffer* command_buffer, VkImage* image,
+                             VkPipelineStageFlags2 src_stages,
+                             VkPipelineStageFlags2 dst_stages,
+                             VkImageLayout old_layout, VkImageLayout new_layout)
+{
+  image_barrier(command_buffer, image, VK_IMAGE_ASPECT_COLOR_BIT, src_stages, 0,
+                dst_stages, 0, old_layout, new_layout);
+}
+
+
+VkExtent2D scaled_render_extent()
+{
+  VkExtent2D extent;
+  extent.width  = swap_chain_extent.width / render_image_scale;
+  extent.height = swap_chain_extent.height / render_image_scale;
+  return extent;
+}
+
+
+void record_ui_pass(graphics_pipeline& ui_pipeline,
+                    std::unordered_map<std::string, entity>& ui_list,
+                    uniform<scene_transform>& scene_ubo,
+                    VkCommandBuffer* command_buffer)
+{
+  const u32 nclear_values                  = 2;
+  VkClearValue clear_values[nclear_values] = {};
+  clear_values[0].color                    = {{0.0f, 0.0f, 0.0f, 1.0f}};
+  clear_values[1].depthStencil             = {1.0f, 0};
+
+  VkDeviceSize offsets[] = {0};
+
+  VkRenderPassBeginInfo ui_pass_info{};
+  ui_pass_info.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  ui_pass_info.renderPass        = ui_pipeline.render_pass;
+  ui_pass_info.framebuffer       = ui_pipeline.framebuffers[0];
+  ui_pass_info.renderArea.offset = {0, 0};
+  ui_pass_info.renderArea.extent = scaled_render_extent();
+  ui_pass_info.clearValueCount   = nclear_values;
+  ui_pass_info.pClearValues      = clear_values;
+
+  vkCmdBeginRenderPass(*command_buffer, &ui_pass_info,
+                       VK_SUBPASS_CONTENTS_INLINE);
+
+  vkCmdBindPipeline(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    ui_pipeline.pipeline);
+
+  vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          ui_pipeline.layout, 0, 1, &scene_ubo.dset.dset, 0,
+                          nullptr);
+
+  for (const auto& pair : ui_list)
+  {
+    const entity& obj = pair.second;
+
+    vkCmdBindVertexBuffers(*command_buffer, 0, 1, &obj.vertices.buffer,
+                           offsets);
+
+    vkCmdBindIndexBuffer(*command_buffer, obj.indices.buffer, 0,
+                         VK_INDEX_TYPE_UINT32);
+
+    vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            ui_pipeline.layout, 1, 1, &obj.ubo.dset.dset, 0,
+                            nullptr);
+
+    vkCmdDrawIndexed(*command_buffer, (u32)obj.indices.nelems, 1, 0, 0, 0);
+  }
+
+  vkCmdEndRenderPass(*command_buffer);
+}
+
+
+// Edge aware upsampling ahead of the present blit (see upsample.cpp). The
+// render loop sets the current mode's resolve pass and its descriptor sets
+// each frame, a null pass blits the render image as is.
+
+struct present_upsample
+{
+  const compute_pass*          resolve;
+  std::vector<VkDescriptorSet> dsets;
+};
+
+present_upsample frame_upsample = {nullptr, {}};
+
+
+void record_upsample_resolve(VkCommandBuffer* command_buffer)
+{
+  // the render image is the guide, the raycast and ui writes land first and
+  // the previous upscaled image is discarded
+
+  image_barrier(command_buffer, &render_image, VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT |
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+  image_barrier(command_buffer, &upscaled_image, VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, 0,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+  frame_upsample.resolve->record(
+  command_buffer, frame_upsample.dsets, nullptr,
+  (swap_chain_extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+  (swap_chain_extent.height + raycast_tile_size - 1) / raycast_tile_size, 1);
+
+  image_barrier(command_buffer, &upscaled_image, VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+
+void record_present_blit(u32 swap_chain_image, VkCommandBuffer* command_buffer)
+{
+  VkExtent2D extent = scaled_render_extent();
+  VkImage    source = render_image;
+
+  if (frame_upsample.resolve != nullptr && render_image_scale > 1)
+  {
+    record_upsample_resolve(command_buffer);
+    extent = swap_chain_extent;
+    source = upscaled_image;
+  }
+
+  transition_image_layout(
+  command_buffer, &swap_chain_images[swap_chain_image],
+  VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+  VkImageSubresourceLayers resource_layers;
+  resource_layers.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  resource_layers.mipLevel       = 0;
+  resource_layers.baseArrayLayer = 0;
+  resource_layers.layerCount     = 1;
+
+  VkImageBlit blit;
+  blit.srcSubresource = resource_layers;
+  blit.srcOffsets[0]  = {0, 0, 0};
+  blit.srcOffsets[1]  = {int(extent.width), int(extent.height), 1};
+  blit.dstSubresource = resource_layers;
+  blit.dstOffsets[0]  = {0, 0, 0};
+  blit.dstOffsets[1]  = {int(swap_chain_extent.width), int(swap_chain_extent.height), 1};
+
+  vkCmdBlitImage(*command_buffer,
+                 source, VK_IMAGE_LAYOUT_GENERAL,
+                 swap_chain_images[swap_chain_image], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 1, &blit, VK_FILTER_LINEAR);
+
+  transition_image_layout(
+  command_buffer, &swap_chain_images[swap_chain_image],
+  VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+
 void record_raycast_command_buffer(
 u32 swap_chain_image, graphics_pipeline& raycast_pipeline,
 graphics_pipeline& ui_pipeline,
 std::unordered_map<std::string, entity>& ui_list,
 uniform<scene_transform>& scene_ubo, descriptor_set& solution_dset,
-VkCommandBuffer* command_buffer)
+gpu_timer& timer, VkCommandBuffer* command_buffer)
 {
   const u32 nclear_values                  = 2;
   VkClearValue clear_values[nclear_values] = {};
@@ -84,13 +293,11 @@ VkCommandBuffer* command_buffer)
   begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   begin_info.pInheritanceInfo = nullptr;
 
-  VkExtent2D render_extent;
-  render_extent.width  = swap_chain_extent.width / render_image_scale;
-  render_extent.height = swap_chain_extent.height / render_image_scale;
-
   VK_CHECK(vkBeginCommandBuffer(*command_buffer, &begin_info),
            "failed to start a command buffer!");
 
+  timer.start(command_buffer);
+
   /* scene pass */
 
   VkRenderPassBeginInfo scene_pass_info{};
@@ -98,7 +305,7 @@ VkCommandBuffer* command_buffer)
   scene_pass_info.renderPass  = raycast_pipeline.render_pass;
   scene_pass_info.framebuffer = raycast_pipeline.framebuffers[0];
   scene_pass_info.renderArea.offset = {0, 0};
-  scene_pass_info.renderArea.extent = render_extent;
+  scene_pass_info.renderArea.extent = scaled_render_extent();
   scene_pass_info.clearValueCount   = nclear_values;
   scene_pass_info.pClearValues      = clear_values;
 
@@ -120,86 +327,123 @@ VkCommandBuffer* command_buffer)
 
   vkCmdEndRenderPass(*command_buffer);
 
+  timer.stop(command_buffer);
+
   /* ui pass */
 
   if (render_ui)
   {
+    record_ui_pass(ui_pipeline, ui_list, scene_ubo, command_buffer);
+  }
 
-    VkDeviceSize offsets[] = {0};
+  // blit to full image
 
-    VkRenderPassBeginInfo ui_pass_info{};
-    ui_pass_info.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    ui_pass_info.renderPass        = ui_pipeline.render_pass;
-    ui_pass_info.framebuffer       = ui_pipeline.framebuffers[0];
-    ui_pass_info.renderArea.offset = {0, 0};
-    ui_pass_info.renderArea.extent = render_extent;
-    ui_pass_info.clearValueCount   = nclear_values;
-    ui_pass_info.pClearValues      = clear_values;
+  record_present_blit(swap_chain_image, command_buffer);
 
-    vkCmdBeginRenderPass(*command_buffer, &ui_pass_info,
-                         VK_SUBPASS_CONTENTS_INLINE);
+  // --
 
-    vkCmdBindPipeline(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                      ui_pipeline.pipeline);
+  VK_CHECK(vkEndCommandBuffer(*command_buffer),
+           "failed to end command buffer!");
+}
 
-    vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            ui_pipeline.layout, 0, 1, &scene_ubo.dset.dset, 0,
-                            nullptr);
 
-    for (const auto& pair : ui_list)
-    {
-      const entity& obj = pair.second;
+// The compute raycast paths share the frame setup around their dispatches:
+// the render image is taken to GENERAL for storage writes, and afterwards
+// made visible to the ui pass and the blit.
+
+void begin_compute_raycast_command_buffer(VkCommandBuffer* command_buffer)
+{
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.pInheritanceInfo = nullptr;
+
+  VK_CHECK(vkBeginCommandBuffer(*command_buffer, &begin_info),
+           "failed to start a command buffer!");
 
-      vkCmdBindVertexBuffers(*command_buffer, 0, 1, &obj.vertices.buffer,
-                             offsets);
+  // the whole render image is overwritten, previous contents are discarded
 
-      vkCmdBindIndexBuffer(*command_buffer, obj.indices.buffer, 0,
-                           VK_INDEX_TYPE_UINT32);
+  image_barrier(command_buffer, &render_image, VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, 0,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+}
 
-      vkCmdBindDescriptorSets(*command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                              ui_pipeline.layout, 1, 1, &obj.ubo.dset.dset, 0,
-                              nullptr);
 
-      vkCmdDrawIndexed(*command_buffer, (u32)obj.indices.nelems, 1, 0, 0, 0);
-    }
+void end_compute_raycast_command_buffer(
+u32 swap_chain_image, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, VkCommandBuffer* command_buffer)
+{
+  // make the raycast result visible to the ui pass and the final blit
+
+  image_barrier(command_buffer, &render_image, VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT |
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
 
-    vkCmdEndRenderPass(*command_buffer);
+  /* ui pass */
 
+  if (render_ui)
+  {
+    // no raster scene pass ran, so the depth image still needs its layout
+
+    image_barrier(command_buffer, &depth_image,
+                  depth_aspect(find_depth_format()),
+                  VK_PIPELINE_STAGE_2_NONE, 0,
+                  VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                  VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                  VK_IMAGE_LAYOUT_UNDEFINED,
+                  VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+    record_ui_pass(ui_pipeline, ui_list, scene_ubo, command_buffer);
   }
 
   // blit to full image
 
-  transition_image_layout(
-  command_buffer, &swap_chain_images[swap_chain_image],
-  VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  record_present_blit(swap_chain_image, command_buffer);
 
-  VkImageSubresourceLayers resource_layers;
-  resource_layers.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-  resource_layers.mipLevel       = 0;
-  resource_layers.baseArrayLayer = 0;
-  resource_layers.layerCount     = 1;
+  // --
 
-  VkImageBlit blit;
-  blit.srcSubresource = resource_layers;
-  blit.srcOffsets[0]  = {0, 0, 0};
-  blit.srcOffsets[1]  = {int(render_extent.width), int(render_extent.height), 1};
-  blit.dstSubresource = resource_layers;
-  blit.dstOffsets[0]  = {0, 0, 0};
-  blit.dstOffsets[1]  = {int(swap_chain_extent.width), int(swap_chain_extent.height), 1};
+  VK_CHECK(vkEndCommandBuffer(*command_buffer),
+           "failed to end command buffer!");
+}
 
-  vkCmdBlitImage(*command_buffer,
-                 render_image, VK_IMAGE_LAYOUT_GENERAL,
-                 swap_chain_images[swap_chain_image], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                 1, &blit, VK_FILTER_LINEAR);
 
-  transition_image_layout(
-  command_buffer, &swap_chain_images[swap_chain_image],
-  VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+void record_tiled_raycast_command_buffer(
+u32 swap_chain_image, compute_pass& raycast_pass,
+graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  begin_compute_raycast_command_buffer(command_buffer);
 
-  // --
+  VkExtent2D extent = scaled_render_extent();
 
-  VK_CHECK(vkEndCommandBuffer(*command_buffer),
-           "failed to end command buffer!");
+  timer.start(command_buffer);
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  };
+
+  raycast_pass.record(command_buffer, dsets, nullptr,
+                      (extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+                      (extent.height + raycast_tile_size - 1) / raycast_tile_size,
+                      1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
 }
@@ -20,15 +20,28 @@
 #include <chrono>
 
 #include "recording.cpp"
+#include "wavefront.cpp"
+#include "binning.cpp"
+#include "temporal.cpp"
+#include "deferred.cpp"
+#include "progressive.cpp"
+#include "upsample.cpp"
+#include "proxy.cpp"
+#include "slice_cache.cpp"
+#include "iso_mesh.cpp"
+#include "governor.cpp"
 #include "swapchain.cpp"
 #include "raycast_data.cpp"
 #include "intersection_acceleration.cpp"
 
 
-void render_loop(raycast_data& rcdata, render_metadata& rcmetadata)
+void render_loop(raycast_data& rcdata, render_metadata& rcmetadata,
+                 const specialization_constants& constants, bool bench,
+                 double target_ms)
 {
   descriptor_set_layout scene_layout(1,  VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
   descriptor_set_layout object_layout(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+  descriptor_set_layout target_layout(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 
   std::unordered_map<std::string, graphics_pipeline> pipelines;
 
@@ -37,25 +50,211 @@ void render_loop(raycast_data& rcdata, render_metadata& rcmetadata)
   graphics_pipeline(SHADER_DIR "axis_vert.spv",
                     SHADER_DIR "axis_frag.spv",
                     VK_ATTACHMENT_LOAD_OP_LOAD, true, scene_layout,
-                    object_layout, *rcdata.raycast_descset.layout));
+                    object_layout, *rcdata.raycast_descset.layout, constants));
   pipelines.emplace(
   "raycast_surface",
   graphics_pipeline(SHADER_DIR "raycast_canvas.spv",
                     SHADER_DIR "raycast_surface.spv",
                     VK_ATTACHMENT_LOAD_OP_CLEAR, false, scene_layout,
-                    object_layout, *rcdata.raycast_descset.layout));
+                    object_layout, *rcdata.raycast_descset.layout, constants));
   pipelines.emplace(
   "raycast_slice",
   graphics_pipeline(SHADER_DIR "raycast_canvas.spv",
                     SHADER_DIR "raycast_slice.spv",
                     VK_ATTACHMENT_LOAD_OP_CLEAR, false, scene_layout,
-                    object_layout, *rcdata.raycast_descset.layout));
+                    object_layout, *rcdata.raycast_descset.layout, constants));
   pipelines.emplace(
   "raycast_isosurface",
   graphics_pipeline(SHADER_DIR "raycast_canvas.spv",
                     SHADER_DIR "raycast_isosurface.spv",
                     VK_ATTACHMENT_LOAD_OP_CLEAR, false, scene_layout,
-                    object_layout, *rcdata.raycast_descset.layout));
+                    object_layout, *rcdata.raycast_descset.layout, constants));
+  pipelines.emplace(
+  "raycast_boundary",
+  graphics_pipeline(SHADER_DIR "raycast_canvas.spv",
+                    SHADER_DIR "raycast_boundary.spv",
+                    VK_ATTACHMENT_LOAD_OP_CLEAR, false, scene_layout,
+                    object_layout, *rcdata.raycast_descset.layout, constants));
+  pipelines.emplace(
+  "raycast_volume",
+  graphics_pipeline(SHADER_DIR "raycast_canvas.spv",
+                    SHADER_DIR "raycast_volume.spv",
+                    VK_ATTACHMENT_LOAD_OP_CLEAR, false, scene_layout,
+                    object_layout, *rcdata.raycast_descset.layout, constants));
+  pipelines.emplace(
+  "raycast_slices",
+  graphics_pipeline(SHADER_DIR "raycast_canvas.spv",
+                    SHADER_DIR "raycast_slices.spv",
+                    VK_ATTACHMENT_LOAD_OP_CLEAR, false, scene_layout,
+                    object_layout, *rcdata.raycast_descset.layout, constants));
+  pipelines.emplace(
+  "raycast_proxy",
+  graphics_pipeline(SHADER_DIR "raycast_proxy_vert.spv",
+                    SHADER_DIR "raycast_proxy_frag.spv",
+                    VK_ATTACHMENT_LOAD_OP_CLEAR, true, scene_layout,
+                    object_layout, *rcdata.raycast_descset.layout, constants));
+  pipelines.emplace(
+  "raycast_isomesh",
+  graphics_pipeline(SHADER_DIR "raycast_proxy_vert.spv",
+                    SHADER_DIR "raycast_isomesh_frag.spv",
+                    VK_ATTACHMENT_LOAD_OP_CLEAR, true, scene_layout,
+                    object_layout, *rcdata.raycast_descset.layout, constants));
+
+  // tiled compute variants of the raycast modes (set 1 is the render target)
+
+  std::vector<descriptor_set_layout*> tiled_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout};
+
+  std::unordered_map<std::string, compute_pass> tiled_passes;
+
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    std::string name = std::string("raycast_") + raycast_mode_names[mi];
+    tiled_passes.emplace(
+    name, compute_pass(SHADER_DIR + name + "_tiled.spv", tiled_layouts, 0,
+                       constants));
+  }
+
+  // tile cooperative variants stage one element's coefficients at a time in
+  // shared memory, packet variants traverse with subgroup votes, both fall
+  // back to the plain tiled shaders if the device can't run them
+
+  u32 nbfp = (constants.p + 1) * (constants.p + 1) * (constants.p + 1);
+  u32 nbfq = (constants.q + 1) * (constants.q + 1) * (constants.q + 1);
+  u32 cooperative_shared = (3 * nbfq + 5 * nbfp) * sizeof(float) +
+                           2 * 16 * sizeof(float) + 2 * sizeof(s32);
+
+  VkPhysicalDeviceSubgroupProperties subgroup_properties{};
+  subgroup_properties.sType =
+  VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+  VkPhysicalDeviceProperties2 properties{};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &subgroup_properties;
+  vkGetPhysicalDeviceProperties2(physical_device, &properties);
+
+  bool cooperative_fits =
+  cooperative_shared <= properties.properties.limits.maxComputeSharedMemorySize;
+  if (!cooperative_fits)
+  {
+    printf("cooperative raycast needs %d bytes of shared memory (device "
+           "limit %d), using the tiled shaders instead\n",
+           (int)cooperative_shared,
+           (int)properties.properties.limits.maxComputeSharedMemorySize);
+  }
+
+  bool packet_votes =
+  (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+  (subgroup_properties.supportedOperations & VK_SUBGROUP_FEATURE_VOTE_BIT);
+  if (!packet_votes)
+  {
+    printf("packet raycast needs subgroup votes in compute shaders, using the "
+           "tiled shaders instead\n");
+  }
+
+  auto add_tile_variant = [&](raycast_path path, const std::string& suffix,
+                              bool usable) {
+    for (u32 mi = 0; mi < nraycast_modes; ++mi)
+    {
+      if (!raycast_path_supported[mi][(int)path])
+        continue;
+
+      std::string name = std::string("raycast_") + raycast_mode_names[mi];
+      tiled_passes.emplace(
+      name + suffix,
+      compute_pass(SHADER_DIR + name + (usable ? suffix : "_tiled") + ".spv",
+                   tiled_layouts, 0, constants));
+    }
+  };
+
+  add_tile_variant(raycast_path::cooperative, "_cooperative", cooperative_fits);
+  add_tile_variant(raycast_path::packet, "_packet", packet_votes);
+
+  descriptor_set render_target(&target_layout);
+
+  // wavefront kernels (set 3 holds the ray queues)
+
+  wavefront_data wfdata;
+
+  std::vector<descriptor_set_layout*> wavefront_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout,
+  &wfdata.layout};
+
+  std::unordered_map<std::string, compute_pass> wavefront_passes;
+  make_wavefront_passes(wavefront_passes, wavefront_layouts, constants);
+
+  // screen tile binning kernels (set 3 holds the tile lists)
+
+  binning_data bins(rcdata.d_bboxes.nelems);
+
+  std::vector<descriptor_set_layout*> binning_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout, &bins.layout};
+
+  std::unordered_map<std::string, compute_pass> binning_passes;
+  make_binning_passes(binning_passes, binning_layouts, constants);
+
+  // temporal reuse kernels (set 3 holds the per pixel hit records)
+
+  temporal_data tdata;
+
+  std::vector<descriptor_set_layout*> temporal_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout,
+  &tdata.layout};
+
+  std::unordered_map<std::string, compute_pass> temporal_passes;
+  make_temporal_passes(temporal_passes, temporal_layouts, constants);
+
+  // deferred trace / shade kernels (set 3 holds the visibility buffer)
+
+  visibility_data vdata;
+
+  std::vector<descriptor_set_layout*> deferred_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout,
+  &vdata.layout};
+
+  std::unordered_map<std::string, compute_pass> deferred_passes;
+  make_deferred_passes(deferred_passes, deferred_layouts, constants);
+
+  // progressive refinement kernels (set 3 holds the accumulated colors)
+
+  progressive_data pdata;
+
+  std::vector<descriptor_set_layout*> progressive_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout,
+  &pdata.layout};
+
+  std::unordered_map<std::string, compute_pass> progressive_passes;
+  make_progressive_passes(progressive_passes, progressive_layouts, constants);
+
+  // upsampling kernels (set 3 holds the guide and upscaled images)
+
+  upsample_data udata;
+
+  std::vector<descriptor_set_layout*> upsample_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout,
+  &udata.layout};
+
+  std::unordered_map<std::string, compute_pass> upsample_passes;
+  make_upsample_passes(upsample_passes, upsample_layouts, constants);
+
+  // slice plane cache kernels (set 3 holds the cached plane)
+
+  slice_cache_data cdata;
+
+  std::vector<descriptor_set_layout*> slice_cache_layouts = {
+  &scene_layout, &target_layout, rcdata.raycast_descset.layout,
+  &cdata.layout};
+
+  std::unordered_map<std::string, compute_pass> slice_cache_passes;
+  make_slice_cache_passes(slice_cache_passes, slice_cache_layouts, constants);
+
+  // rasterized boundary face proxy, drawn by the surface and boundary modes
+
+  face_proxy proxy(rcdata, constants);
+
+  // isosurface triangle mesh, extracted the first time the mesh path draws
+
+  iso_mesh isomesh(constants, rcdata.d_bboxes.nelems);
 
   /*
    * add axis to ui ------------------------------------------------------------
@@ -111,9 +310,43 @@ void render_loop(raycast_data& rcdata, render_metadata& rcmetadata)
    */
 
   make_swap_chain_dependencies(pipelines);
+  render_target.update_image(render_image_view, VK_IMAGE_LAYOUT_GENERAL, 0);
+  wfdata.resize(scaled_render_extent());
+  bins.resize(scaled_render_extent());
+  tdata.resize(scaled_render_extent());
+  vdata.resize(scaled_render_extent());
+  pdata.resize(scaled_render_extent());
+  udata.resize();
+  cdata.resize(scaled_render_extent());
 
   uniform<scene_transform> scene_ubo(&scene_layout);
 
+  gpu_timer raycast_timer;
+  double raycast_ms = 0.;
+
+  // benchmarks measure the full quality budgets
+
+  frame_governor governor(bench ? 0. : target_ms);
+  render_scale_locked = governor.target_ms > 0.;
+
+  // path benchmark, each mode is rendered through every raycast path for a
+  // fixed number of frames and the mean raycast time is reported
+
+  const u32 bench_warmup = 16;
+  const u32 bench_frames = 128;
+
+  u32 bench_case  = 0;  // mode * nraycast_paths + path
+  u32 bench_frame = 0;
+
+  auto bench_skip_unsupported = [&]() {
+    while (bench_case < nraycast_modes * nraycast_paths &&
+           !raycast_path_supported[bench_case / nraycast_paths]
+                                  [bench_case % nraycast_paths])
+      ++bench_case;
+  };
+  bench_skip_unsupported();
+  double bench_ms[nraycast_modes][nraycast_paths] = {};
+
   VkPipelineStageFlags wait_stages[] = {
   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 
@@ -139,13 +372,55 @@ void render_loop(raycast_data& rcdata, render_metadata& rcmetadata)
         frame_buffer_resized)
     {
       remake_swap_chain(pipelines);
+      render_target.update_image(render_image_view, VK_IMAGE_LAYOUT_GENERAL, 0);
+      wfdata.resize(scaled_render_extent());
+      bins.resize(scaled_render_extent());
+      tdata.resize(scaled_render_extent());
+      vdata.resize(scaled_render_extent());
+      pdata.resize(scaled_render_extent());
+      udata.resize();
+      cdata.resize(scaled_render_extent());
       frame_buffer_resized = false;
       continue;
     }
 
     // update ui elements
 
+    scene_transform last_transform = scene_ubo.host_data;
     update_scene_transform(scene_ubo.host_data, rcmetadata.domain_bbox);
+    governor.apply(scene_ubo.host_data);
+
+    // temporal hit records behind a clip region that moved may now be
+    // occluded by newly uncovered geometry, they are dropped
+
+    if (!clip_region_equal(last_transform, scene_ubo.host_data))
+      tdata.mode = -1;
+
+    // each [ / ] press shifts every isovalue by 1/64 of the output range,
+    // temporal hit records on the old contours are dropped
+
+    if (isovalue_shift != 0)
+    {
+      glm::vec2 range = rcmetadata.domain_output_bounds;
+      for (u32 i = 0; i < niso; ++i)
+        isovalues[i] += (float)isovalue_shift * (range.y - range.x) / 64.f;
+
+      isovalue_shift = 0;
+      tdata.mode     = -1;
+    }
+
+    scene_ubo.host_data.niso = niso;
+    for (u32 i = 0; i < max_isovalues; ++i)
+      scene_ubo.host_data.isovalues[i / 4][i % 4] = isovalues[i];
+
+    // the previous frame has finished so the colormap can be replaced, every
+    // path samples it while shading so no traced state goes stale
+
+    if (colormap_changed)
+    {
+      rcdata.set_colormap(colormap);
+      colormap_changed = false;
+    }
 
     entity& axis = ui_list["axis"];
     update_axis_transform(scene_ubo.host_data, axis.ubo.host_data);
@@ -170,25 +445,112 @@ void render_loop(raycast_data& rcdata, render_metadata& rcmetadata)
 
     // record render command buffer
 
-    switch (RAYCAST_MODE)
+    if (bench)
+    {
+      RAYCAST_MODE = (raycast_mode)(bench_case / nraycast_paths);
+      RAYCAST_PATH[(int)RAYCAST_MODE] =
+      (raycast_path)(bench_case % nraycast_paths);
+    }
+
+    raycast_path path = RAYCAST_PATH[(int)RAYCAST_MODE];
+    std::string  name =
+    std::string("raycast_") + raycast_mode_names[(int)RAYCAST_MODE];
+
+    // downscaled frames are upsampled edge aware before they are presented
+
+    frame_upsample.resolve = render_image_scale > 1 ?
+                             &upsample_passes.at(name + "_upsample") : nullptr;
+    frame_upsample.dsets   = {scene_ubo.dset.dset, render_target.dset,
+                              rcdata.raycast_descset.dset, udata.dset.dset};
+
+    switch (path)
     {
-      case raycast_mode::surface:
+      case raycast_path::fragment:
         record_raycast_command_buffer(
-        swap_chain_image_indx, pipelines["raycast_surface"], pipelines["ui"],
-        ui_list, scene_ubo, rcdata.raycast_descset, &command_buffer);
+        swap_chain_image_indx, pipelines[name], pipelines["ui"], ui_list,
+        scene_ubo, rcdata.raycast_descset, raycast_timer, &command_buffer);
         break;
-      case raycast_mode::slice:
-        record_raycast_command_buffer(
-        swap_chain_image_indx, pipelines["raycast_slice"], pipelines["ui"],
-        ui_list, scene_ubo, rcdata.raycast_descset, &command_buffer);
+      case raycast_path::tiled:
+        record_tiled_raycast_command_buffer(
+        swap_chain_image_indx, tiled_passes.at(name), pipelines["ui"],
+        ui_list, scene_ubo, render_target, rcdata.raycast_descset,
+        raycast_timer, &command_buffer);
         break;
-      case raycast_mode::isosurface:
-        record_raycast_command_buffer(
-        swap_chain_image_indx, pipelines["raycast_isosurface"], pipelines["ui"],
-        ui_list, scene_ubo, rcdata.raycast_descset, &command_buffer);
+      case raycast_path::cooperative:
+        record_tiled_raycast_command_buffer(
+        swap_chain_image_indx, tiled_passes.at(name + "_cooperative"),
+        pipelines["ui"], ui_list, scene_ubo, render_target,
+        rcdata.raycast_descset, raycast_timer, &command_buffer);
+        break;
+      case raycast_path::wavefront:
+        record_wavefront_raycast_command_buffer(
+        swap_chain_image_indx, wavefront_passes, name, pipelines["ui"],
+        ui_list, scene_ubo, render_target, rcdata.raycast_descset, wfdata,
+        raycast_timer, &command_buffer);
+        break;
+      case raycast_path::packet:
+        record_tiled_raycast_command_buffer(
+        swap_chain_image_indx, tiled_passes.at(name + "_packet"),
+        pipelines["ui"], ui_list, scene_ubo, render_target,
+        rcdata.raycast_descset, raycast_timer, &command_buffer);
+        break;
+      case raycast_path::binned:
+        record_binned_raycast_command_buffer(
+        swap_chain_image_indx, binning_passes, name, pipelines["ui"], ui_list,
+        scene_ubo, render_target, rcdata.raycast_descset, bins, raycast_timer,
+        &command_buffer);
+        break;
+      case raycast_path::temporal:
+        record_temporal_raycast_command_buffer(
+        swap_chain_image_indx, temporal_passes, name, pipelines["ui"],
+        ui_list, scene_ubo, render_target, rcdata.raycast_descset, tdata,
+        raycast_timer, &command_buffer);
+        break;
+      case raycast_path::deferred:
+        record_deferred_raycast_command_buffer(
+        swap_chain_image_indx, deferred_passes, name, pipelines["ui"],
+        ui_list, scene_ubo, render_target, rcdata.raycast_descset, vdata,
+        raycast_timer, &command_buffer);
+        break;
+      case raycast_path::progressive:
+        record_progressive_raycast_command_buffer(
+        swap_chain_image_indx, progressive_passes, name, pipelines["ui"],
+        ui_list, scene_ubo, render_target, rcdata.raycast_descset, pdata,
+        raycast_timer, &command_buffer);
+        break;
+      case raycast_path::cached:
+        record_cached_raycast_command_buffer(
+        swap_chain_image_indx, slice_cache_passes, pipelines["ui"], ui_list,
+        scene_ubo, render_target, rcdata.raycast_descset, cdata,
+        raycast_timer, &command_buffer);
+        break;
+      case raycast_path::mesh:
+        isomesh.update(rcdata, constants, scene_ubo.host_data);
+        record_iso_mesh_command_buffer(
+        swap_chain_image_indx, pipelines["raycast_isomesh"],
+        tiled_passes.at(name), pipelines["ui"], ui_list, scene_ubo,
+        render_target, rcdata.raycast_descset, isomesh, raycast_timer,
+        &command_buffer);
+        break;
+      case raycast_path::raster:
+        record_proxy_raycast_command_buffer(
+        swap_chain_image_indx, pipelines["raycast_proxy"], pipelines["ui"],
+        ui_list, scene_ubo, rcdata.raycast_descset, proxy.vertices,
+        proxy.indices, (u32)proxy.indices.nelems, raycast_timer,
+        &command_buffer);
         break;
     }
 
+    // hit records, the visibility buffer and the accumulated colors go stale
+    // while another path renders
+
+    if (path != raycast_path::temporal)
+      tdata.mode = -1;
+    if (path != raycast_path::deferred)
+      vdata.mode = -1;
+    if (path != raycast_path::progressive)
+      pdata.mode = -1;
+
     // submit command buffer
 
     VkSubmitInfo si{};
@@ -227,11 +589,68 @@ void render_loop(raycast_data& rcdata, render_metadata& rcmetadata)
     auto t1 = std::chrono::steady_clock::now();
     std::chrono::duration<double, std::milli> frame_time = t1 - t0;
 
+    if (!raycast_timer.elapsed_ms(raycast_ms))
+      raycast_ms = frame_time.count();
+
+    governor.update(raycast_ms);
+
+    if (bench)
+    {
+      if (bench_frame >= bench_warmup)
+        bench_ms[bench_case / nraycast_paths][bench_case % nraycast_paths] +=
+        raycast_ms / (double)bench_frames;
+
+      if (++bench_frame == bench_warmup + bench_frames)
+      {
+        bench_frame = 0;
+        ++bench_case;
+        bench_skip_unsupported();
+        if (bench_case == nraycast_modes * nraycast_paths)
+          glfwSetWindowShouldClose(window, GLFW_TRUE);
+      }
+    }
+
     char title[256];
-    snprintf(title, 256, "cpu frame time: %.1f ms", frame_time.count());
+    int  title_len =
+    snprintf(title, 256, "cpu frame time: %.1f ms | %s raycast: %.2f ms",
+             frame_time.count(), raycast_path_names[(int)path], raycast_ms);
+    if (governor.target_ms > 0.)
+    {
+      const frame_budget& budget = frame_budgets[governor.level];
+      snprintf(title + title_len, 256 - title_len,
+               " | target %.1f ms: scale %d, rounds %d/%d/%d, tol x%.0f",
+               governor.target_ms, (int)render_image_scale,
+               (int)budget.surface_rounds, (int)budget.iso_rounds,
+               (int)budget.slice_steps, budget.tol_scale);
+    }
     glfwSetWindowTitle(window, title);
   }
 
+  if (bench && bench_case == nraycast_modes * nraycast_paths)
+  {
+    printf("\n");
+    printf("  raycast path benchmark (%d x %d, %s time per frame):\n",
+           (int)scaled_render_extent().width,
+           (int)scaled_render_extent().height,
+           raycast_timer.supported ? "gpu" : "cpu");
+    printf("    %-10s", "mode");
+    for (u32 pi = 0; pi < nraycast_paths; ++pi)
+      printf(" | %11s", raycast_path_names[pi]);
+    printf("\n");
+    for (u32 mi = 0; mi < nraycast_modes; ++mi)
+    {
+      printf("    %-10s", raycast_mode_names[mi]);
+      for (u32 pi = 0; pi < nraycast_paths; ++pi)
+      {
+        if (raycast_path_supported[mi][pi])
+          printf(" | %8.2f ms", bench_ms[mi][pi]);
+        else
+          printf(" | %11s", "-");
+      }
+      printf("\n");
+    }
+  }
+
   vkDeviceWaitIdle(device);
 
   vkDestroyFence(device, render_in_progress, nullptr);
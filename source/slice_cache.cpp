@@ -0,0 +1,172 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// slice plane cache, the output is resampled onto a plane aligned grid only
+// when the slice plane changes and frames in between look it up where rays
+// cross the plane (see shaders/slice_cache.glsl)
+
+struct slice_cache_constants
+{
+  u32 size;
+};
+
+struct slice_cache_data
+{
+  u32 size;  // texels along each side of the cached square
+
+  // the plane the cache was filled for, valid is false if it must be refilled
+  bool      valid;
+  glm::mat4 slice_model;
+  u32       slice_steps;
+  float     tol_scale;
+
+  dbuffer<glm::vec2> d_texels;
+
+  descriptor_set_layout layout;
+  descriptor_set        dset;
+
+  // ---
+
+  slice_cache_data();
+
+  // the resolution follows the render image, call after swap chain changes
+  void resize(VkExtent2D extent);
+};
+
+void make_slice_cache_passes(
+std::unordered_map<std::string, compute_pass>& passes,
+const std::vector<descriptor_set_layout*>& layouts,
+const specialization_constants& constants);
+
+void record_cached_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, slice_cache_data& cdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+slice_cache_data::slice_cache_data() :
+size(0),
+valid(false),
+slice_model(1.f),
+slice_steps(0),
+tol_scale(0.f),
+d_texels(),
+layout(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+dset(&layout)
+{}
+
+void slice_cache_data::resize(VkExtent2D extent)
+{
+  // about one texel per pixel when the plane fills the view
+
+  size  = std::min(std::max(std::max(extent.width, extent.height), 64u), 2048u);
+  valid = false;
+
+  d_texels = dbuffer<glm::vec2>(size * size);
+  dmalloc(d_texels);
+
+  dset.update(d_texels, 0);
+}
+
+void make_slice_cache_passes(
+std::unordered_map<std::string, compute_pass>& passes,
+const std::vector<descriptor_set_layout*>& layouts,
+const specialization_constants& constants)
+{
+  for (const char* pass : {"_fill", "_view"})
+  {
+    std::string name = std::string("raycast_slice_cache") + pass;
+    passes.emplace(name,
+                   compute_pass(SHADER_DIR + name + ".spv", layouts,
+                                sizeof(slice_cache_constants), constants));
+  }
+}
+
+void record_cached_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, slice_cache_data& cdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const compute_pass& fill = passes.at("raycast_slice_cache_fill");
+  const compute_pass& view = passes.at("raycast_slice_cache_view");
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  cdata.dset.dset,
+  };
+
+  // camera motion leaves the cache valid, the plane and the point location
+  // budgets do not
+
+  const scene_transform& transform = scene_ubo.host_data;
+
+  bool refill = !cdata.valid || cdata.slice_model != transform.slice_model ||
+                cdata.slice_steps != transform.slice_steps ||
+                cdata.tol_scale != transform.tol_scale;
+  if (refill)
+  {
+    cdata.valid       = true;
+    cdata.slice_model = transform.slice_model;
+    cdata.slice_steps = transform.slice_steps;
+    cdata.tol_scale   = transform.tol_scale;
+  }
+
+  slice_cache_constants sc;
+  sc.size = cdata.size;
+
+  VkExtent2D extent = scaled_render_extent();
+
+  begin_compute_raycast_command_buffer(command_buffer);
+
+  timer.start(command_buffer);
+
+  if (refill)
+  {
+    fill.record(command_buffer, dsets, &sc, (cdata.size + 8 - 1) / 8,
+                (cdata.size + 8 - 1) / 8, 1);
+    compute_barrier(command_buffer);
+  }
+  view.record(command_buffer, dsets, &sc,
+              (extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+              (extent.height + raycast_tile_size - 1) / raycast_tile_size, 1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
+}
@@ -55,8 +55,42 @@ bool   mouse_left_pressed  = false;
 bool   mouse_right_pressed = false;
 
 raycast_mode RAYCAST_MODE  = raycast_mode::surface;
+raycast_path RAYCAST_PATH[nraycast_modes] = {  // indexed by raycast mode
+raycast_path::fragment,
+raycast_path::fragment,
+raycast_path::fragment,
+raycast_path::fragment,
+raycast_path::fragment,
+raycast_path::fragment,
+};
 output_type  render_output = output_type::mach;
 float*       colormap      = colormap_jet;
+bool         colormap_changed = false;  // shading only, no retrace needed
+
+// isosurface mode contours, all found in one traversal, [ and ] shift them
+// (applied by the render loop, which knows the output range)
+const u32 max_isovalues            = 8;  // scene_transform holds as many
+u32       niso                     = 1;
+float     isovalues[max_isovalues] = {0.075f};
+s32       isovalue_shift           = 0;
+
+// slice set mode planes, a stack of nslices planes along the slice normal or
+// the three planes of the slice frame (O toggles)
+const u32 max_slices       = 20;  // scene_transform holds as many
+u32       nslices          = 8;
+bool      slice_orthogonal = false;
+
+// clip region, command line half spaces dot(n, p) <= d as (n, d) and box,
+// plus the slice frame's plane while clipping at the slice (H toggles)
+const u32 max_clip_planes              = 4;  // scene_transform holds as many
+u32       nclip_planes                 = 0;
+glm::vec4 clip_planes[max_clip_planes] = {};
+bool      clip_box_on                  = false;
+aabb      clip_box;
+bool      clip_at_slice                = false;
+
+// the isosurface mesh path raycasts exactly once the view is still (E toggles)
+bool iso_mesh_exact_when_still = true;
 
 bool mesh_display_toggle_on = false;
 bool modify_slice           = false;
@@ -100,10 +134,24 @@ VkImage        depth_image        = VK_NULL_HANDLE;
 VkDeviceMemory depth_image_memory = VK_NULL_HANDLE;
 VkImageView    depth_image_view   = VK_NULL_HANDLE;
 
+// the render image is written as a storage image by the tiled raycaster,
+// swap chain (sRGB) formats generally lack storage support so a float format
+// is used and converted by the final blit
+
+const VkFormat render_image_format = VK_FORMAT_R16G16B16A16_SFLOAT;
+
 VkImage        render_image        = VK_NULL_HANDLE;
 VkDeviceMemory render_image_memory = VK_NULL_HANDLE;
 VkImageView    render_image_view   = VK_NULL_HANDLE;
 usize          render_image_scale  = 1;
+bool           render_scale_locked = false;  // set by the frame governor
+
+// full resolution image a downscaled render image is upsampled into before
+// presenting (see upsample.cpp), only made while render_image_scale > 1
+
+VkImage        upscaled_image        = VK_NULL_HANDLE;
+VkDeviceMemory upscaled_image_memory = VK_NULL_HANDLE;
+VkImageView    upscaled_image_view   = VK_NULL_HANDLE;
 
 bool frame_buffer_resized = false;
 
@@ -157,6 +205,9 @@ void clean_swap_chain()
   vkDestroyImageView(device, render_image_view, nullptr);
   vkDestroyImage(device, render_image, nullptr);
   vkFreeMemory(device, render_image_memory, nullptr);
+  vkDestroyImageView(device, upscaled_image_view, nullptr);
+  vkDestroyImage(device, upscaled_image, nullptr);
+  vkFreeMemory(device, upscaled_image_memory, nullptr);
   delete[] swap_chain_images;
   delete[] swap_chain_image_views;
 }
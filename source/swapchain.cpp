@@ -40,13 +40,31 @@ void make_render_image()
 {
   make_image(
   swap_chain_extent.width / render_image_scale,
-  swap_chain_extent.height / render_image_scale, swap_chain_image_format,
+  swap_chain_extent.height / render_image_scale, render_image_format,
   VK_IMAGE_TILING_OPTIMAL,
-  VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+  VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+  VK_IMAGE_USAGE_STORAGE_BIT,
   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, render_image, render_image_memory);
 
-  render_image_view = make_image_view(render_image, swap_chain_image_format,
+  render_image_view = make_image_view(render_image, render_image_format,
                                       VK_IMAGE_ASPECT_COLOR_BIT);
+
+  upscaled_image        = VK_NULL_HANDLE;
+  upscaled_image_memory = VK_NULL_HANDLE;
+  upscaled_image_view   = VK_NULL_HANDLE;
+
+  if (render_image_scale > 1)
+  {
+    make_image(
+    swap_chain_extent.width, swap_chain_extent.height, render_image_format,
+    VK_IMAGE_TILING_OPTIMAL,
+    VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, upscaled_image,
+    upscaled_image_memory);
+
+    upscaled_image_view = make_image_view(upscaled_image, render_image_format,
+                                          VK_IMAGE_ASPECT_COLOR_BIT);
+  }
 }
 
 
@@ -0,0 +1,196 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// temporal hit reuse, every pixel keeps its last hit which is reprojected
+// into the next frame and tried before a full traversal (see
+// shaders/temporal.glsl)
+
+const u32 temporal_width = 64;  // must match shaders/temporal.glsl
+
+struct temporal_constants
+{
+  u32 current;
+};
+
+struct temporal_data
+{
+  u32  npixel;
+  u32  current;  // half of d_hits written by the next frame
+  s32  mode;     // raycast mode the records belong to, -1 if none
+
+  dbuffer<temporal_hit> d_hits;
+  dbuffer<u32>          d_reproj_depth;
+  dbuffer<u32>          d_reproj_src;
+
+  descriptor_set_layout layout;
+  descriptor_set        dset;
+
+  // ---
+
+  temporal_data();
+
+  // buffers are sized by the render image, call after swap chain changes
+  void resize(VkExtent2D extent);
+};
+
+void make_temporal_passes(std::unordered_map<std::string, compute_pass>& passes,
+                          const std::vector<descriptor_set_layout*>& layouts,
+                          const specialization_constants& constants);
+
+void record_temporal_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, temporal_data& tdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+temporal_data::temporal_data() :
+npixel(0),
+current(0),
+mode(-1),
+d_hits(),
+d_reproj_depth(),
+d_reproj_src(),
+layout(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+dset(&layout)
+{}
+
+void temporal_data::resize(VkExtent2D extent)
+{
+  npixel = extent.width * extent.height;
+  mode   = -1;
+
+  d_hits         = dbuffer<temporal_hit>(2 * npixel);
+  d_reproj_depth = dbuffer<u32>(npixel);
+  d_reproj_src   = dbuffer<u32>(npixel);
+
+  dmalloc(d_hits);
+  dmalloc(d_reproj_depth);
+  dmalloc(d_reproj_src);
+
+  dset.update(d_hits,         0);
+  dset.update(d_reproj_depth, 1);
+  dset.update(d_reproj_src,   2);
+}
+
+void make_temporal_passes(std::unordered_map<std::string, compute_pass>& passes,
+                          const std::vector<descriptor_set_layout*>& layouts,
+                          const specialization_constants& constants)
+{
+  std::vector<std::string> names = {
+  "temporal_reproject_depth",
+  "temporal_reproject",
+  };
+
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    if (!raycast_path_supported[mi][(int)raycast_path::temporal])
+      continue;
+
+    names.push_back(std::string("raycast_") + raycast_mode_names[mi] +
+                    "_temporal");
+  }
+
+  for (const std::string& name : names)
+  {
+    passes.emplace(name, compute_pass(SHADER_DIR + name + ".spv", layouts,
+                                      sizeof(temporal_constants), constants));
+  }
+}
+
+void record_temporal_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, temporal_data& tdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const compute_pass& reproject_depth = passes.at("temporal_reproject_depth");
+  const compute_pass& reproject       = passes.at("temporal_reproject");
+  const compute_pass& raycast         = passes.at(mode_name + "_temporal");
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  tdata.dset.dset,
+  };
+
+  temporal_constants tc;
+  tc.current = tdata.current;
+
+  u32 pixel_groups = (tdata.npixel + temporal_width - 1) / temporal_width;
+
+  begin_compute_raycast_command_buffer(command_buffer);
+
+  timer.start(command_buffer);
+
+  // records from another mode (or none at all) can't be reused, all ones
+  // marks every record as a miss (elem = -1)
+
+  if (tdata.mode != (s32)RAYCAST_MODE)
+  {
+    vkCmdFillBuffer(*command_buffer, tdata.d_hits.buffer, 0, VK_WHOLE_SIZE,
+                    0xffffffff);
+    tdata.mode = (s32)RAYCAST_MODE;
+  }
+
+  vkCmdFillBuffer(*command_buffer, tdata.d_reproj_depth.buffer, 0,
+                  VK_WHOLE_SIZE, 0xffffffff);
+  vkCmdFillBuffer(*command_buffer, tdata.d_reproj_src.buffer, 0, VK_WHOLE_SIZE,
+                  0xffffffff);
+
+  memory_barrier(command_buffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                 VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                 VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+  // reproject the previous frame's hits, then trace
+
+  reproject_depth.record(command_buffer, dsets, &tc, pixel_groups, 1, 1);
+  compute_barrier(command_buffer);
+  reproject.record(command_buffer, dsets, &tc, pixel_groups, 1, 1);
+  compute_barrier(command_buffer);
+
+  VkExtent2D extent = scaled_render_extent();
+  raycast.record(command_buffer, dsets, &tc,
+                 (extent.width  + raycast_tile_size - 1) / raycast_tile_size,
+                 (extent.height + raycast_tile_size - 1) / raycast_tile_size,
+                 1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
+
+  tdata.current = 1 - tdata.current;
+}
@@ -17,6 +17,8 @@
 #pragma once
 
 
+#include <cstring>
+
 #include "state.cpp"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -30,6 +32,30 @@ struct scene_transform
 
   glm::mat4 slice_model = glm::mat4(1.f);
 
+  // intersection budgets, lowered by the frame governor (see governor.cpp)
+  u32   surface_rounds = 50;
+  u32   iso_rounds     = 10;
+  u32   slice_steps    = 3;
+  float tol_scale      = 1.f;
+
+  // isosurface mode contours, niso of them packed 4 per vec4 (std140)
+  glm::vec4 isovalues[2] = {glm::vec4(0.f), glm::vec4(0.f)};
+  u32       niso         = 0;
+
+  // slice set mode planes as (normal, offset), see update_slice_planes
+  u32       nslices                  = 0;
+  u32       slice_pad[2]             = {0, 0};  // std140 vec4 alignment
+  glm::vec4 slice_planes[max_slices] = {};
+
+  // clip region half spaces dot(n, p) <= d as (n, d) and box, see
+  // update_clip_region
+  u32       nclip_planes                 = 0;
+  u32       clip_box_on                  = 0;
+  u32       clip_pad[2]                  = {0, 0};  // std140 vec4 alignment
+  glm::vec4 clip_planes[max_clip_planes] = {};
+  glm::vec4 clip_box_l                   = glm::vec4(0.f);
+  glm::vec4 clip_box_h                   = glm::vec4(0.f);
+
   scene_transform()
   {
     glm::mat4 cam_model = glm::mat4(1.f);
@@ -156,6 +182,65 @@ void model_space_rotation(const scene_transform& mvp, const glm::mat4& cam_model
   m_rot = -glm::vec4(glm::cross(m_last3, m_curr3), 0.f);
 }
 
+// Places the slice set mode planes from the slice frame, either the frame's
+// three coordinate planes or a stack of evenly spaced planes along its normal
+// spanning the domain's extent in that direction, centered on the frame.
+void update_slice_planes(scene_transform& mvp, const aabb& domain_bbox)
+{
+  glm::vec3 origin(mvp.slice_model[3]);
+
+  if (slice_orthogonal)
+  {
+    mvp.nslices = 3;
+    for (u32 i = 0; i < 3; ++i)
+    {
+      glm::vec3 normal = glm::normalize(glm::vec3(mvp.slice_model[i]));
+      mvp.slice_planes[i] = glm::vec4(normal, glm::dot(normal, origin));
+    }
+    return;
+  }
+
+  glm::vec3 normal = glm::normalize(glm::vec3(mvp.slice_model[2]));
+  float     span   = glm::dot(glm::abs(normal), domain_bbox.h - domain_bbox.l);
+
+  mvp.nslices = glm::min(nslices, max_slices);
+  for (u32 i = 0; i < mvp.nslices; ++i)
+  {
+    float offset = ((i + 0.5f) / (float)mvp.nslices - 0.5f) * span;
+    mvp.slice_planes[i] =
+    glm::vec4(normal, glm::dot(normal, origin) + offset);
+  }
+}
+
+// Fills the clip region from the command line planes and box, adding the
+// slice frame's plane (keeping the side its normal points away from) while
+// clipping at the slice is on.
+void update_clip_region(scene_transform& mvp)
+{
+  mvp.nclip_planes = 0;
+  for (u32 i = 0; i < nclip_planes; ++i)
+    mvp.clip_planes[mvp.nclip_planes++] = clip_planes[i];
+
+  if (clip_at_slice && mvp.nclip_planes < max_clip_planes)
+  {
+    glm::vec3 origin(mvp.slice_model[3]);
+    glm::vec3 normal = glm::normalize(glm::vec3(mvp.slice_model[2]));
+    mvp.clip_planes[mvp.nclip_planes++] =
+    glm::vec4(normal, glm::dot(normal, origin));
+  }
+
+  mvp.clip_box_on = clip_box_on ? 1 : 0;
+  mvp.clip_box_l  = glm::vec4(clip_box.l, 0.f);
+  mvp.clip_box_h  = glm::vec4(clip_box.h, 0.f);
+}
+
+bool clip_region_equal(const scene_transform& a, const scene_transform& b)
+{
+  return a.nclip_planes == b.nclip_planes && a.clip_box_on == b.clip_box_on &&
+         memcmp(a.clip_planes, b.clip_planes, sizeof(a.clip_planes)) == 0 &&
+         a.clip_box_l == b.clip_box_l && a.clip_box_h == b.clip_box_h;
+}
+
 void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
 {
   /* projection matrix */
@@ -168,6 +253,12 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
 
   /* camera manipulation */
 
+  // the slice frame is moved instead of the camera while C is held
+
+  bool move_slice = modify_slice && (RAYCAST_MODE == raycast_mode::slice ||
+                                     RAYCAST_MODE == raycast_mode::slices ||
+                                     clip_at_slice);
+
   glm::mat4 cam_model = glm::inverse(mvp.view);
 
   // zoom : update cam distance maintaining offset direction
@@ -186,7 +277,7 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
   {
     glm::vec4 m_trans = model_space_translation(mvp);
 
-    if (RAYCAST_MODE == raycast_mode::slice && modify_slice)
+    if (move_slice)
     {
       glm::mat4 smodinv = glm::inverse(mvp.slice_model);
       mvp.slice_model   = glm::translate(mvp.slice_model,
@@ -208,7 +299,7 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
 
     if (glm::abs(ang) > 1e-3f)
     {
-      if (RAYCAST_MODE == raycast_mode::slice && modify_slice)
+      if (move_slice)
       {
         glm::mat4 smodinv = glm::inverse(mvp.slice_model);
         mvp.slice_model   = glm::rotate(mvp.slice_model,
@@ -236,7 +327,7 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
 
   if (view_axis_x_set)
   {
-    if (RAYCAST_MODE == raycast_mode::slice && modify_slice)
+    if (move_slice)
     {
       mvp.slice_model =
         glm::rotate(glm::mat4(1.f), pi_2, glm::vec3(0.f, 1.f, 0.f));
@@ -251,7 +342,7 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
 
   if (view_axis_y_set)
   {
-    if (RAYCAST_MODE == raycast_mode::slice && modify_slice)
+    if (move_slice)
     {
       mvp.slice_model =
         glm::rotate(glm::mat4(1.f), pi_2, glm::vec3(1.f, 0.f, 0.f));
@@ -266,7 +357,7 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
 
   if (view_axis_z_set)
   {
-    if (RAYCAST_MODE == raycast_mode::slice && modify_slice)
+    if (move_slice)
     {
       mvp.slice_model = glm::mat4(1.f);
     }
@@ -279,6 +370,9 @@ void update_scene_transform(scene_transform& mvp, aabb& domain_bbox)
   }
 
   mvp.view = glm::inverse(cam_model);
+
+  update_slice_planes(mvp, domain_bbox);
+  update_clip_region(mvp);
 }
 
 void update_axis_transform(const scene_transform& scene_ubo,
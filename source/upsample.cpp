@@ -0,0 +1,79 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// edge aware upsampling, while the render image is downscaled (R key or the
+// frame governor) the present blit first fills a full resolution image from
+// it, interpolating where it is unambiguous and re-tracing at full resolution
+// elsewhere (see shaders/upsample.glsl and record_present_blit)
+
+struct upsample_data
+{
+  descriptor_set_layout layout;  // guide (render) image, upscaled image
+  descriptor_set        dset;
+
+  // ---
+
+  upsample_data();
+
+  // binds the images, call after swap chain changes
+  void resize();
+};
+
+void make_upsample_passes(std::unordered_map<std::string, compute_pass>& passes,
+                          const std::vector<descriptor_set_layout*>& layouts,
+                          const specialization_constants& constants);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+upsample_data::upsample_data() :
+layout(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE),
+dset(&layout)
+{}
+
+void upsample_data::resize()
+{
+  // the upscaled image only exists while the render image is downscaled
+
+  if (upscaled_image_view == VK_NULL_HANDLE)
+    return;
+
+  dset.update_image(render_image_view,   VK_IMAGE_LAYOUT_GENERAL, 0);
+  dset.update_image(upscaled_image_view, VK_IMAGE_LAYOUT_GENERAL, 1);
+}
+
+void make_upsample_passes(std::unordered_map<std::string, compute_pass>& passes,
+                          const std::vector<descriptor_set_layout*>& layouts,
+                          const specialization_constants& constants)
+{
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    std::string mode = std::string("raycast_") + raycast_mode_names[mi];
+    passes.emplace(mode + "_upsample",
+                   compute_pass(SHADER_DIR + mode + "_upsample.spv", layouts, 0,
+                                constants));
+  }
+}
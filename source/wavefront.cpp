@@ -0,0 +1,281 @@
+/* ELM                                                                        */
+/* Copyright (C) 2024  Miles McGruder                                         */
+/*                                                                            */
+/* This program is free software: you can redistribute it and/or modify       */
+/* it under the terms of the GNU General Public License as published by       */
+/* the Free Software Foundation, either version 3 of the License, or          */
+/* (at your option) any later version.                                        */
+/*                                                                            */
+/* This program is distributed in the hope that it will be useful,            */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of             */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              */
+/* GNU General Public License for more details.                               */
+/*                                                                            */
+/* You should have received a copy of the GNU General Public License          */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.     */
+
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "recording.cpp"
+
+
+// wavefront raycasting, rays move through separate generate / traverse /
+// intersect / resolve / compact / shade kernels connected by compacted ray
+// queues (see shaders/wavefront.glsl)
+
+const u32 wavefront_chunk  = 4;     // must match shaders/wavefront.glsl
+const u32 wavefront_width  = 64;    // *
+const u32 scan_block_size  = 1024;  // *
+const u32 wavefront_rounds = 32;    // the shade pass finishes rays left live
+
+struct wavefront_constants
+{
+  u32 queue;
+  u32 scan_target;
+};
+
+struct wavefront_counters
+{
+  glm::uvec4 ray_dispatch[2];
+  glm::uvec4 scan_dispatch[2];
+  glm::uvec4 item_dispatch;
+};
+
+struct wavefront_data
+{
+  u32 npixel;
+
+  dbuffer<wavefront_ray>      d_rays;
+  dbuffer<u32>                d_queue;
+  dbuffer<u32>                d_values;
+  dbuffer<u32>                d_offsets;
+  dbuffer<u32>                d_block_sums;
+  dbuffer<glm::vec4>          d_items;
+  dbuffer<wavefront_counters> d_counters;
+
+  descriptor_set_layout layout;
+  descriptor_set        dset;
+
+  // ---
+
+  wavefront_data();
+
+  // buffers are sized by the render image, call after swap chain changes
+  void resize(VkExtent2D extent);
+};
+
+void make_wavefront_passes(
+std::unordered_map<std::string, compute_pass>& passes,
+const std::vector<descriptor_set_layout*>& layouts,
+const specialization_constants& constants);
+
+void record_wavefront_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, wavefront_data& wfdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer);
+
+
+/* IMPLEMENTATION ----------------------------------------------------------- */
+
+
+wavefront_data::wavefront_data() :
+npixel(0),
+d_rays(),
+d_queue(),
+d_values(),
+d_offsets(),
+d_block_sums(),
+d_items(),
+d_counters(),
+layout(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+dset(&layout)
+{}
+
+void wavefront_data::resize(VkExtent2D extent)
+{
+  npixel = extent.width * extent.height;
+
+  d_rays       = dbuffer<wavefront_ray>(npixel);
+  d_queue      = dbuffer<u32>(2 * npixel);
+  d_values     = dbuffer<u32>(npixel);
+  d_offsets    = dbuffer<u32>(npixel);
+  d_block_sums = dbuffer<u32>((npixel + scan_block_size - 1) / scan_block_size);
+  d_items      = dbuffer<glm::vec4>(wavefront_chunk * npixel);
+  d_counters   = dbuffer<wavefront_counters>(
+  1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+  dmalloc(d_rays);
+  dmalloc(d_queue);
+  dmalloc(d_values);
+  dmalloc(d_offsets);
+  dmalloc(d_block_sums);
+  dmalloc(d_items);
+  dmalloc(d_counters);
+
+  dset.update(d_rays,       0);
+  dset.update(d_queue,      1);
+  dset.update(d_values,     2);
+  dset.update(d_offsets,    3);
+  dset.update(d_block_sums, 4);
+  dset.update(d_items,      5);
+  dset.update(d_counters,   6);
+}
+
+void make_wavefront_passes(
+std::unordered_map<std::string, compute_pass>& passes,
+const std::vector<descriptor_set_layout*>& layouts,
+const specialization_constants& constants)
+{
+  std::vector<std::string> names = {
+  "wavefront_generate",
+  "wavefront_traverse",
+  "wavefront_resolve",
+  "wavefront_compact",
+  "scan_local",
+  "scan_blocks",
+  };
+
+  for (u32 mi = 0; mi < nraycast_modes; ++mi)
+  {
+    if (!raycast_path_supported[mi][(int)raycast_path::wavefront])
+      continue;
+
+    std::string mode = std::string("raycast_") + raycast_mode_names[mi];
+    names.push_back(mode + "_intersect");
+    names.push_back(mode + "_shade");
+  }
+
+  for (const std::string& name : names)
+  {
+    passes.emplace(name, compute_pass(SHADER_DIR + name + ".spv", layouts,
+                                      sizeof(wavefront_constants), constants));
+  }
+}
+
+void record_wavefront_raycast_command_buffer(
+u32 swap_chain_image, std::unordered_map<std::string, compute_pass>& passes,
+const std::string& mode_name, graphics_pipeline& ui_pipeline,
+std::unordered_map<std::string, entity>& ui_list,
+uniform<scene_transform>& scene_ubo, descriptor_set& target_dset,
+descriptor_set& solution_dset, wavefront_data& wfdata, gpu_timer& timer,
+VkCommandBuffer* command_buffer)
+{
+  const compute_pass& generate  = passes.at("wavefront_generate");
+  const compute_pass& traverse  = passes.at("wavefront_traverse");
+  const compute_pass& intersect = passes.at(mode_name + "_intersect");
+  const compute_pass& resolve   = passes.at("wavefront_resolve");
+  const compute_pass& compact   = passes.at("wavefront_compact");
+  const compute_pass& shade     = passes.at(mode_name + "_shade");
+  const compute_pass& scan      = passes.at("scan_local");
+  const compute_pass& scan_top  = passes.at("scan_blocks");
+
+  std::vector<VkDescriptorSet> dsets = {
+  scene_ubo.dset.dset,
+  target_dset.dset,
+  solution_dset.dset,
+  wfdata.dset.dset,
+  };
+
+  VkBuffer     args = wfdata.d_counters.buffer;
+  VkDeviceSize ray_args[2]  = {offsetof(wavefront_counters, ray_dispatch),
+                               offsetof(wavefront_counters, ray_dispatch) +
+                               sizeof(glm::uvec4)};
+  VkDeviceSize scan_args[2] = {offsetof(wavefront_counters, scan_dispatch),
+                               offsetof(wavefront_counters, scan_dispatch) +
+                               sizeof(glm::uvec4)};
+  VkDeviceSize item_args    = offsetof(wavefront_counters, item_dispatch);
+
+  u32 npixel = wfdata.npixel;
+
+  begin_compute_raycast_command_buffer(command_buffer);
+
+  timer.start(command_buffer);
+
+  // every pixel starts in queue half 0
+
+  wavefront_counters initial{};
+  initial.ray_dispatch[0] =
+  glm::uvec4((npixel + wavefront_width - 1) / wavefront_width, 1, 1, npixel);
+  initial.scan_dispatch[0] =
+  glm::uvec4((npixel + scan_block_size - 1) / scan_block_size, 1, 1, 0);
+
+  vkCmdUpdateBuffer(*command_buffer, args, 0, sizeof(wavefront_counters),
+                    &initial);
+
+  memory_barrier(command_buffer, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                 VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                 VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                 VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                 VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+
+  // generate and compact the rays that enter the domain into half 1
+
+  wavefront_constants wfc;
+  wfc.queue       = 0;
+  wfc.scan_target = 1;
+
+  generate.record(command_buffer, dsets, &wfc,
+                  (npixel + wavefront_width - 1) / wavefront_width, 1, 1);
+  compute_barrier(command_buffer);
+  scan.record_indirect(command_buffer, dsets, &wfc, args, scan_args[0]);
+  compute_barrier(command_buffer);
+  scan_top.record(command_buffer, dsets, &wfc, 1, 1, 1);
+  compute_barrier(command_buffer);
+  compact.record_indirect(command_buffer, dsets, &wfc, args, ray_args[0]);
+  compute_barrier(command_buffer);
+
+  // traversal rounds, empty queues dispatch zero workgroups
+
+  u32 queue = 1;
+  for (u32 round = 0; round < wavefront_rounds; ++round)
+  {
+    wfc.queue       = queue;
+    wfc.scan_target = 0;
+
+    traverse.record_indirect(command_buffer, dsets, &wfc, args,
+                             ray_args[queue]);
+    compute_barrier(command_buffer);
+    scan.record_indirect(command_buffer, dsets, &wfc, args, scan_args[queue]);
+    compute_barrier(command_buffer);
+    scan_top.record(command_buffer, dsets, &wfc, 1, 1, 1);
+    compute_barrier(command_buffer);
+    intersect.record_indirect(command_buffer, dsets, &wfc, args, item_args);
+    compute_barrier(command_buffer);
+    resolve.record_indirect(command_buffer, dsets, &wfc, args,
+                            ray_args[queue]);
+    compute_barrier(command_buffer);
+
+    wfc.scan_target = 1;
+
+    scan.record_indirect(command_buffer, dsets, &wfc, args, scan_args[queue]);
+    compute_barrier(command_buffer);
+    scan_top.record(command_buffer, dsets, &wfc, 1, 1, 1);
+    compute_barrier(command_buffer);
+    compact.record_indirect(command_buffer, dsets, &wfc, args,
+                            ray_args[queue]);
+    compute_barrier(command_buffer);
+
+    queue = 1 - queue;
+  }
+
+  // shade every pixel from its final ray record, rays the rounds did not
+  // finish are traced to completion there
+
+  VkExtent2D extent = scaled_render_extent();
+  shade.record(command_buffer, dsets, &wfc, (extent.width + 7) / 8,
+               (extent.height + 7) / 8, 1);
+
+  timer.stop(command_buffer);
+
+  end_compute_raycast_command_buffer(swap_chain_image, ui_pipeline, ui_list,
+                                     scene_ubo, command_buffer);
+}